@@ -801,7 +801,7 @@ int mutt_save_attachment(FILE *fp, struct Body *m, char *path, int flags, struct
         mx_close_mailbox(&ctx, NULL);
         return -1;
       }
-      if (ctx.magic == MUTT_MBOX || ctx.magic == MUTT_MMDF)
+      if (ctx.magic == MUTT_MBOX || ctx.magic == MUTT_MMDF || ctx.magic == MUTT_ZMBOX)
         chflags = CH_FROM | CH_UPDATE_LEN;
       chflags |= (ctx.magic == MUTT_MAILDIR ? CH_NOSTATUS : CH_UPDATE);
       if (mutt_copy_message_fp(msg->fp, fp, hn, 0, chflags) == 0 &&
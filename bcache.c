@@ -24,15 +24,20 @@
 #include "config.h"
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 #include "mutt/mutt.h"
 #include "bcache.h"
 #include "globals.h"
 #include "mutt_account.h"
+#include "options.h"
 #include "protos.h"
 #include "url.h"
 
@@ -43,6 +48,7 @@ struct BodyCache
 {
   char path[_POSIX_PATH_MAX];
   size_t pathlen;
+  struct BcachePack *pack; /**< NULL unless $message_cache_packed is set */
 };
 
 static int bcache_path(struct Account *account, const char *mailbox, char *dst, size_t dstlen)
@@ -88,16 +94,1191 @@ static int bcache_path(struct Account *account, const char *mailbox, char *dst,
   return 0;
 }
 
-static int mutt_bcache_move(struct BodyCache *bcache, const char *id, const char *newid)
+/* Directory under $message_cachedir holding one link to each distinct body */
+#define BCACHE_OBJECTS ".objects"
+
+/* Log of a packed cache, in the cache's directory */
+#define BCACHE_PACK_INDEX "bcache.idx"
+#define BCACHE_PACK_MAGIC "neomutt-bcache-1"
+
+/* Don't bother compacting a pack with less than this much wasted */
+#define BCACHE_PACK_MIN_DEAD (1024 * 1024)
+
+/**
+ * struct BcacheFile - A file found while measuring the cache
+ */
+struct BcacheFile
+{
+  char *path;
+  time_t atime; /**< last time the body was read */
+  long atime_ns;
+  dev_t dev;
+  ino_t ino;
+  off_t size;
+};
+
+/**
+ * struct BcacheScan - All the files in the cache
+ */
+struct BcacheScan
+{
+  struct BcacheFile *files;
+  size_t count;
+  size_t max;
+};
+
+/* Bytes used by $message_cachedir, -1 if it hasn't been measured yet */
+static off_t CacheUsage = -1;
+
+/**
+ * bcache_scan - Find all the files in a directory tree
+ * @param dir     Directory to search
+ * @param objects true if dir is inside the objects directory
+ * @param scan    Where to store the files
+ *
+ * Files still being written, "*.tmp", are ignored, as are the logs of packed
+ * caches: a pack is evicted as a whole, and its log is reset the next time
+ * it's used.  A body with no other links than the one in the objects
+ * directory is marked as never read, so that it's evicted first.
+ */
+static void bcache_scan(const char *dir, bool objects, struct BcacheScan *scan)
+{
+  DIR *d = opendir(dir);
+  if (!d)
+    return;
+
+  char path[PATH_MAX];
+  struct dirent *de = NULL;
+  struct stat st;
+
+  while ((de = readdir(d)))
+  {
+    if ((strcmp(de->d_name, ".") == 0) || (strcmp(de->d_name, "..") == 0))
+      continue;
+
+    if (snprintf(path, sizeof(path), "%s/%s", dir, de->d_name) >= sizeof(path))
+    {
+      mutt_debug(1, "bcache: scan: path too long: %s/%s\n", dir, de->d_name);
+      continue;
+    }
+    if (lstat(path, &st) < 0)
+      continue;
+
+    if (S_ISDIR(st.st_mode))
+    {
+      bcache_scan(path, objects || (strcmp(de->d_name, BCACHE_OBJECTS) == 0), scan);
+      continue;
+    }
+
+    size_t len = mutt_str_strlen(de->d_name);
+    if (!S_ISREG(st.st_mode) || ((len > 4) && (strcmp(de->d_name + len - 4, ".tmp") == 0)) ||
+        (strcmp(de->d_name, BCACHE_PACK_INDEX) == 0))
+    {
+      continue;
+    }
+
+    if (scan->count == scan->max)
+    {
+      scan->max += 256;
+      mutt_mem_realloc(&scan->files, scan->max * sizeof(struct BcacheFile));
+    }
+
+    struct BcacheFile *f = &scan->files[scan->count++];
+    f->path = mutt_str_strdup(path);
+    if (objects && (st.st_nlink == 1))
+    {
+      f->atime = 0;
+      f->atime_ns = 0;
+    }
+    else
+    {
+      f->atime = st.st_atime;
+#ifdef HAVE_STRUCT_STAT_ST_ATIM
+      f->atime_ns = st.st_atim.tv_nsec;
+#else
+      f->atime_ns = 0;
+#endif
+    }
+    f->dev = st.st_dev;
+    f->ino = st.st_ino;
+    f->size = st.st_size;
+  }
+
+  closedir(d);
+}
+
+/**
+ * bcache_file_cmp - Sort the cache files, least recently read first
+ * @param a First file
+ * @param b Second file
+ * @retval <0 a should be evicted first
+ * @retval  0 a and b are the same body
+ * @retval >0 b should be evicted first
+ *
+ * Links to the same body end up next to each other.
+ */
+static int bcache_file_cmp(const void *a, const void *b)
+{
+  const struct BcacheFile *fa = a;
+  const struct BcacheFile *fb = b;
+
+  if (fa->atime != fb->atime)
+    return (fa->atime < fb->atime) ? -1 : 1;
+  if (fa->atime_ns != fb->atime_ns)
+    return (fa->atime_ns < fb->atime_ns) ? -1 : 1;
+  if (fa->dev != fb->dev)
+    return (fa->dev < fb->dev) ? -1 : 1;
+  if (fa->ino != fb->ino)
+    return (fa->ino < fb->ino) ? -1 : 1;
+  return 0;
+}
+
+/**
+ * bcache_same_body - Do two cache files belong to the same body?
+ * @param a First file
+ * @param b Second file
+ * @retval true If they are links to the same inode
+ */
+static bool bcache_same_body(const struct BcacheFile *a, const struct BcacheFile *b)
+{
+  return (a->dev == b->dev) && (a->ino == b->ino);
+}
+
+/**
+ * bcache_evict - Keep the cache within $message_cache_size
+ *
+ * Measure the whole of $message_cachedir, shared by all the accounts.  If it's
+ * too big, delete the bodies that haven't been read for the longest time,
+ * until it's back under 90% of the limit, so that the next few messages can
+ * be cached without scanning it again.
+ */
+static void bcache_evict(void)
+{
+  struct BcacheScan scan = { 0 };
+  off_t limit = (off_t) MessageCacheSize * 1024 * 1024;
+  off_t used = 0;
+  int removed = 0;
+
+  bcache_scan(MessageCachedir, false, &scan);
+  if (scan.count > 1)
+    qsort(scan.files, scan.count, sizeof(struct BcacheFile), bcache_file_cmp);
+
+  /* a body with several links takes up space only once */
+  for (size_t i = 0; i < scan.count; i++)
+    if ((i == 0) || !bcache_same_body(&scan.files[i - 1], &scan.files[i]))
+      used += scan.files[i].size;
+
+  mutt_debug(2, "bcache: evict: %ld bytes in %zu files, limit %ld\n",
+             (long) used, scan.count, (long) limit);
+
+  if (used > limit)
+  {
+    const off_t target = limit / 10 * 9;
+    for (size_t i = 0; (i < scan.count) && (used > target); i++)
+    {
+      if (unlink(scan.files[i].path) == 0)
+        removed++;
+      if ((i + 1 == scan.count) || !bcache_same_body(&scan.files[i], &scan.files[i + 1]))
+        used -= scan.files[i].size;
+    }
+    mutt_debug(2, "bcache: evict: removed %d files, %ld bytes left\n", removed, (long) used);
+  }
+
+  for (size_t i = 0; i < scan.count; i++)
+    FREE(&scan.files[i].path);
+  FREE(&scan.files);
+
+  CacheUsage = used;
+}
+
+/**
+ * bcache_charge - Account for a change in the size of the cache
+ * @param size Bytes added, or removed if negative
+ */
+static void bcache_charge(off_t size)
+{
+  if (MessageCacheSize <= 0)
+    return;
+
+  if (CacheUsage < 0)
+  {
+    bcache_evict();
+    return;
+  }
+
+  CacheUsage += size;
+  if (CacheUsage < 0)
+    CacheUsage = 0;
+  else if (CacheUsage > (off_t) MessageCacheSize * 1024 * 1024)
+    bcache_evict();
+}
+
+/**
+ * bcache_object_path - Find where a body is kept in the objects directory
+ * @param path   Path of the cached body
+ * @param obj    Buffer for the path of the object
+ * @param objlen Length of the buffer
+ * @retval  0 Success
+ * @retval -1 Error
+ *
+ * Objects are named after the MD5 of their contents.
+ */
+static int bcache_object_path(const char *path, char *obj, size_t objlen)
+{
+  unsigned char md5[16];
+  char hex[33];
+
+  FILE *fp = mutt_file_fopen(path, "r");
+  if (!fp)
+    return -1;
+  int rc = mutt_md5_stream(fp, md5);
+  mutt_file_fclose(&fp);
+  if (rc != 0)
+    return -1;
+
+  for (int i = 0; i < 16; i++)
+    sprintf(hex + 2 * i, "%02x", md5[i]);
+
+  if (snprintf(obj, objlen, "%s/%s/%.2s/%s", MessageCachedir, BCACHE_OBJECTS,
+               hex, hex + 2) >= objlen)
+    return -1;
+
+  return 0;
+}
+
+/**
+ * bcache_same_contents - Compare two files
+ * @param a Path of the first file
+ * @param b Path of the second file
+ * @retval true If the files are identical
+ *
+ * The MD5 only finds candidates; a body is only ever shared with an identical
+ * one, so a crafted collision can't change what another message displays.
+ */
+static bool bcache_same_contents(const char *a, const char *b)
+{
+  char bufa[BUFSIZ], bufb[BUFSIZ];
+  bool same = false;
+  size_t na, nb;
+
+  FILE *fpa = mutt_file_fopen(a, "r");
+  FILE *fpb = mutt_file_fopen(b, "r");
+  if (!fpa || !fpb)
+    goto done;
+
+  do
+  {
+    na = fread(bufa, 1, sizeof(bufa), fpa);
+    nb = fread(bufb, 1, sizeof(bufb), fpb);
+    if ((na != nb) || (memcmp(bufa, bufb, na) != 0))
+      goto done;
+  } while (na > 0);
+
+  same = !ferror(fpa) && !ferror(fpb);
+
+done:
+  mutt_file_fclose(&fpa);
+  mutt_file_fclose(&fpb);
+  return same;
+}
+
+/**
+ * bcache_dedup - Share a newly cached body with an identical one
+ * @param path Path of the new body
+ * @param st   Details of the new body
+ * @retval true  The file is now a link to an existing body
+ * @retval false The file is kept, and may be shared by later bodies
+ */
+static bool bcache_dedup(const char *path, const struct stat *st)
+{
+  char obj[PATH_MAX];
+  char lnk[PATH_MAX];
+  struct stat ost;
+
+  if (bcache_object_path(path, obj, sizeof(obj)) < 0)
+    return false;
+
+  if (lstat(obj, &ost) < 0)
+  {
+    /* the first copy of this body */
+    if ((mutt_file_mkdir(mutt_file_dirname(obj), S_IRWXU) == 0) && (link(path, obj) == 0))
+      mutt_debug(3, "bcache: dedup: new object '%s'\n", obj);
+    return false;
+  }
+
+  if (!S_ISREG(ost.st_mode) || (ost.st_size != st->st_size) ||
+      ((ost.st_dev == st->st_dev) && (ost.st_ino == st->st_ino)) ||
+      !bcache_same_contents(obj, path))
+  {
+    return false;
+  }
+
+  /* replace the new file in one step, so the body is never missing */
+  if (snprintf(lnk, sizeof(lnk), "%s.lnk", path) >= sizeof(lnk))
+    return false;
+  unlink(lnk);
+  if ((link(obj, lnk) < 0) || (rename(lnk, path) < 0))
+  {
+    unlink(lnk);
+    return false;
+  }
+
+  mutt_debug(3, "bcache: dedup: '%s' shares '%s'\n", path, obj);
+  return true;
+}
+
+/**
+ * struct BcachePackEntry - Where a body lives in a pack
+ */
+struct BcachePackEntry
+{
+  off_t offset;
+  off_t length;
+};
+
+/**
+ * struct BcachePack - A cache stored in one file
+ *
+ * All the bodies of a mailbox are appended to a single pack file.  A log,
+ * BCACHE_PACK_INDEX, records where each one starts, and which ones have been
+ * deleted.  It is read into a hash table, so finding a body costs neither a
+ * directory lookup nor an inode.
+ *
+ * The log starts with a generation number, which names the pack file.  When
+ * more than half of the pack has been deleted, it is compacted into a new
+ * generation and the log is replaced in one step.  Other processes notice
+ * the new log and reread it.
+ */
+struct BcachePack
+{
+  struct Hash *index; /**< id -> struct BcachePackEntry */
+  FILE *log;          /**< BCACHE_PACK_INDEX */
+  int fd;             /**< pack file, -1 if it isn't open yet */
+  unsigned int gen;   /**< generation of the pack file */
+  off_t loaded;       /**< how much of the log has been read */
+  off_t live;         /**< bytes of the pack still in use */
+  off_t dead;         /**< bytes of the pack that have been deleted */
+};
+
+/**
+ * pack_path - Get the path of one of the pack's files
+ * @param bcache Body cache
+ * @param gen    Generation of the pack file, or 0 for the log
+ * @param buf    Buffer for the result
+ * @param buflen Length of the buffer
+ * @retval  0 Success
+ * @retval -1 The path is too long
+ */
+static int pack_path(struct BodyCache *bcache, unsigned int gen, char *buf, size_t buflen)
+{
+  int len;
+
+  if (gen == 0)
+    len = snprintf(buf, buflen, "%s%s", bcache->path, BCACHE_PACK_INDEX);
+  else
+    len = snprintf(buf, buflen, "%sbcache.%u.pack", bcache->path, gen);
+
+  if ((len < 0) || ((size_t) len >= buflen))
+  {
+    mutt_debug(1, "bcache: pack: path too long: %s\n", bcache->path);
+    return -1;
+  }
+
+  return 0;
+}
+
+/**
+ * pack_entry_free - Free a BcachePackEntry, callback for the hash table
+ * @param data Entry to free
+ */
+static void pack_entry_free(void *data)
+{
+  FREE(&data);
+}
+
+/**
+ * pack_forget - Forget the bodies that have been read from the log
+ * @param pack Pack
+ */
+static void pack_forget(struct BcachePack *pack)
+{
+  mutt_hash_destroy(&pack->index, pack_entry_free);
+  pack->index = mutt_hash_create(1024, MUTT_HASH_STRDUP_KEYS);
+  if (pack->fd >= 0)
+    close(pack->fd);
+  pack->fd = -1;
+  pack->loaded = 0;
+  pack->live = 0;
+  pack->dead = 0;
+}
+
+/**
+ * pack_close - Close the files of a pack
+ * @param pack Pack
+ */
+static void pack_close(struct BcachePack *pack)
+{
+  pack_forget(pack);
+  mutt_file_fclose(&pack->log);
+}
+
+/**
+ * pack_open - Open the log of a pack
+ * @param bcache Body cache
+ * @retval  0 Success
+ * @retval -1 Error
+ */
+static int pack_open(struct BodyCache *bcache)
+{
+  char path[PATH_MAX];
+
+  if (bcache->pack->log)
+    return 0;
+
+  if (pack_path(bcache, 0, path, sizeof(path)) < 0)
+    return -1;
+
+  bcache->pack->log = mutt_file_fopen(path, "a+");
+  if (!bcache->pack->log)
+  {
+    mutt_debug(1, "bcache: pack: can't open '%s': %s\n", path, strerror(errno));
+    return -1;
+  }
+
+  return 0;
+}
+
+/**
+ * pack_stale - Has the log been replaced by another process?
+ * @param bcache Body cache
+ * @retval true If the log must be reopened
+ */
+static bool pack_stale(struct BodyCache *bcache)
+{
+  char path[PATH_MAX];
+  struct stat st_path, st_fd;
+
+  if ((pack_path(bcache, 0, path, sizeof(path)) < 0) || (stat(path, &st_path) < 0) ||
+      (fstat(fileno(bcache->pack->log), &st_fd) < 0))
+    return true;
+
+  return (st_path.st_dev != st_fd.st_dev) || (st_path.st_ino != st_fd.st_ino);
+}
+
+/**
+ * pack_record - Apply one line of the log
+ * @param pack Pack
+ * @param line Line, without its newline
+ */
+static void pack_record(struct BcachePack *pack, const char *line)
+{
+  long long offset, length;
+  int n = 0;
+
+  if ((line[0] == '+') &&
+      (sscanf(line + 1, " %lld %lld %n", &offset, &length, &n) == 2) && (n > 0))
+  {
+    const char *id = line + 1 + n;
+    struct BcachePackEntry *e = mutt_hash_find(pack->index, id);
+    if (e)
+    {
+      pack->live -= e->length;
+      pack->dead += e->length;
+    }
+    else
+    {
+      e = mutt_mem_calloc(1, sizeof(struct BcachePackEntry));
+      mutt_hash_insert(pack->index, id, e);
+    }
+    e->offset = offset;
+    e->length = length;
+    pack->live += length;
+  }
+  else if ((line[0] == '-') && (line[1] == ' '))
+  {
+    struct BcachePackEntry *e = mutt_hash_find(pack->index, line + 2);
+    if (e)
+    {
+      pack->live -= e->length;
+      pack->dead += e->length;
+      mutt_hash_delete(pack->index, line + 2, e, pack_entry_free);
+    }
+  }
+  else
+    mutt_debug(1, "bcache: pack: bad record '%s'\n", line);
+}
+
+/**
+ * pack_create - Start a new, empty, generation of a pack
+ * @param bcache Body cache
+ * @retval  0 Success
+ * @retval -1 Error
+ *
+ * The log must be locked.  Other processes may still be reading it, so it
+ * isn't rewritten in place: the new log is renamed over it, as in
+ * pack_compact(), and they'll see that theirs is stale.  The new log is
+ * locked in its place.
+ */
+static int pack_create(struct BodyCache *bcache)
+{
+  struct BcachePack *pack = bcache->pack;
+  char path[PATH_MAX];
+  char logpath[PATH_MAX];
+  char tmplog[PATH_MAX];
+  unsigned int gen = pack->gen + 1;
+  FILE *fplog = NULL;
+
+  pack_forget(pack);
+
+  if ((pack_path(bcache, gen, path, sizeof(path)) < 0) ||
+      (pack_path(bcache, 0, logpath, sizeof(logpath)) < 0) ||
+      (snprintf(tmplog, sizeof(tmplog), "%s.tmp", logpath) >= sizeof(tmplog)))
+  {
+    return -1;
+  }
+
+  pack->fd = open(path, O_RDWR | O_APPEND | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+  if (pack->fd < 0)
+  {
+    mutt_debug(1, "bcache: pack: can't create '%s': %s\n", path, strerror(errno));
+    return -1;
+  }
+
+  fplog = mutt_file_fopen(tmplog, "w+");
+  if (!fplog || (mutt_file_lock(tmplog, fileno(fplog), true, false) < 0) ||
+      (fprintf(fplog, "%s %u\n", BCACHE_PACK_MAGIC, gen) < 0) ||
+      (fflush(fplog) != 0) || (rename(tmplog, logpath) < 0))
+  {
+    mutt_debug(1, "bcache: pack: can't create '%s': %s\n", logpath, strerror(errno));
+    mutt_file_fclose(&fplog);
+    unlink(tmplog);
+    pack_forget(pack);
+    unlink(path);
+    return -1;
+  }
+
+  mutt_file_unlock(logpath, fileno(pack->log));
+  mutt_file_fclose(&pack->log);
+  pack->log = fplog;
+  pack->gen = gen;
+  pack->loaded = ftello(pack->log);
+  mutt_debug(2, "bcache: pack: created '%s'\n", path);
+  return 0;
+}
+
+/**
+ * pack_load - Read the new records of the log
+ * @param bcache Body cache
+ * @param locked true if the log is locked, so the pack may be (re)created
+ * @retval  0 Success
+ * @retval -1 Error
+ *
+ * Only whole lines are read, so records that are still being written by
+ * another process are left for the next time.
+ */
+static int pack_load(struct BodyCache *bcache, bool locked)
+{
+  struct BcachePack *pack = bcache->pack;
+  char line[LONG_STRING];
+  struct stat st;
+
+  /* a log that has shrunk has been rewritten, so its offsets are no use */
+  if ((pack->loaded > 0) && (fstat(fileno(pack->log), &st) == 0) &&
+      (st.st_size < pack->loaded))
+  {
+    pack_forget(pack);
+  }
+
+  if (pack->loaded == 0)
+  {
+    char path[PATH_MAX];
+    char magic[32];
+    unsigned int gen = 0;
+
+    rewind(pack->log);
+    if (!fgets(line, sizeof(line), pack->log) ||
+        (sscanf(line, "%31s %u", magic, &gen) != 2) ||
+        (mutt_str_strcmp(magic, BCACHE_PACK_MAGIC) != 0))
+    {
+      /* new, or damaged beyond use */
+      return locked ? pack_create(bcache) : 0;
+    }
+
+    if (pack_path(bcache, gen, path, sizeof(path)) < 0)
+      return -1;
+
+    pack->fd = open(path, O_RDWR | O_APPEND);
+    if (pack->fd < 0)
+    {
+      /* the pack has been evicted, start again */
+      pack->gen = gen;
+      return locked ? pack_create(bcache) : 0;
+    }
+
+    pack->gen = gen;
+    pack->loaded = ftello(pack->log);
+  }
+
+  if (fseeko(pack->log, pack->loaded, SEEK_SET) != 0)
+    return -1;
+
+  while (fgets(line, sizeof(line), pack->log))
+  {
+    size_t len = mutt_str_strlen(line);
+    if ((len == 0) || (line[len - 1] != '\n'))
+      break;
+
+    line[len - 1] = '\0';
+    pack_record(pack, line);
+    pack->loaded = ftello(pack->log);
+  }
+
+  return 0;
+}
+
+/**
+ * pack_lock - Lock a pack, ready to change it
+ * @param bcache Body cache
+ * @retval  0 Success, the log is locked and up to date
+ * @retval -1 Error
+ */
+static int pack_lock(struct BodyCache *bcache)
+{
+  struct BcachePack *pack = bcache->pack;
+  char path[PATH_MAX];
+
+  if (pack_path(bcache, 0, path, sizeof(path)) < 0)
+    return -1;
+
+  for (int tries = 0; tries < 3; tries++)
+  {
+    if (pack_open(bcache) < 0)
+      return -1;
+
+    if (mutt_file_lock(path, fileno(pack->log), true, true) < 0)
+      return -1;
+
+    if (!pack_stale(bcache))
+    {
+      /* the pack may have been evicted while we weren't looking */
+      if (pack->fd >= 0)
+      {
+        char ppath[PATH_MAX];
+        struct stat st_path, st_fd;
+        if ((pack_path(bcache, pack->gen, ppath, sizeof(ppath)) < 0) ||
+            (stat(ppath, &st_path) < 0) || (fstat(pack->fd, &st_fd) < 0) ||
+            (st_path.st_ino != st_fd.st_ino) || (st_path.st_dev != st_fd.st_dev))
+        {
+          pack_forget(pack);
+        }
+      }
+
+      if ((pack_load(bcache, true) == 0) && (pack->fd >= 0))
+        return 0;
+
+      mutt_file_unlock(path, fileno(pack->log));
+      return -1;
+    }
+
+    /* compacted by another process */
+    mutt_file_unlock(path, fileno(pack->log));
+    pack_close(pack);
+  }
+
+  return -1;
+}
+
+/**
+ * pack_unlock - Unlock a pack
+ * @param bcache Body cache
+ */
+static void pack_unlock(struct BodyCache *bcache)
+{
+  char path[PATH_MAX];
+
+  /* the lock belongs to the open log, the path is only informative */
+  if (pack_path(bcache, 0, path, sizeof(path)) < 0)
+    mutt_str_strfcpy(path, bcache->path, sizeof(path));
+  mutt_file_unlock(path, fileno(bcache->pack->log));
+}
+
+/**
+ * pack_append - Add a record to the log
+ * @param pack Pack, whose log is locked
+ * @param line Record, without its newline
+ * @retval  0 Success
+ * @retval -1 Error
+ */
+static int pack_append(struct BcachePack *pack, const char *line)
+{
+  if (fseeko(pack->log, 0, SEEK_END) != 0)
+    return -1;
+
+  /* finish off a record left incomplete by a crash */
+  if ((ftello(pack->log) != pack->loaded) && (fputc('\n', pack->log) == EOF))
+    return -1;
+
+  if ((fprintf(pack->log, "%s\n", line) < 0) || (fflush(pack->log) != 0))
+    return -1;
+
+  pack_record(pack, line);
+  pack->loaded = ftello(pack->log);
+  return 0;
+}
+
+/**
+ * pack_refresh - Catch up with the changes made by other processes
+ * @param bcache Body cache
+ * @retval  0 Success, the pack file is open unless there isn't one yet
+ * @retval -1 Error
+ */
+static int pack_refresh(struct BodyCache *bcache)
+{
+  struct BcachePack *pack = bcache->pack;
+
+  if (pack->log && pack_stale(bcache))
+    pack_close(pack);
+
+  if ((pack_open(bcache) < 0) || (pack_load(bcache, false) < 0))
+    return -1;
+
+  return 0;
+}
+
+/**
+ * pack_find - Find a body in a pack
+ * @param bcache Body cache
+ * @param id     Id of the body
+ * @retval ptr  Location of the body
+ * @retval NULL Not in the cache
+ *
+ * If the body isn't known, catch up with the changes made by other processes.
+ */
+static struct BcachePackEntry *pack_find(struct BodyCache *bcache, const char *id)
+{
+  struct BcachePack *pack = bcache->pack;
+
+  if (pack->fd >= 0)
+  {
+    struct BcachePackEntry *e = mutt_hash_find(pack->index, id);
+    if (e)
+      return e;
+  }
+
+  if ((pack_refresh(bcache) < 0) || (pack->fd < 0))
+    return NULL;
+
+  return mutt_hash_find(pack->index, id);
+}
+
+/**
+ * pack_copy - Copy bytes to the end of a pack
+ * @param fd     Pack file
+ * @param fpin   Source
+ * @param length Number of bytes written
+ * @retval  0 Success
+ * @retval -1 Error
+ */
+static int pack_copy(int fd, FILE *fpin, off_t *length)
+{
+  char buf[BUFSIZ];
+  size_t n;
+
+  *length = 0;
+  while ((n = fread(buf, 1, sizeof(buf), fpin)) > 0)
+  {
+    if (write(fd, buf, n) != (ssize_t) n)
+      return -1;
+    *length += n;
+  }
+
+  return ferror(fpin) ? -1 : 0;
+}
+
+/**
+ * pack_commit - Move a temporary file into a pack
+ * @param bcache Body cache
+ * @param id     Id of the body
+ * @param tmp    Path of the temporary file
+ * @retval  0 Success
+ * @retval -1 Error
+ */
+static int pack_commit(struct BodyCache *bcache, const char *id, const char *tmp)
+{
+  struct BcachePack *pack = bcache->pack;
+  off_t offset, length = 0;
+  int rc = -1;
+
+  FILE *fp = mutt_file_fopen(tmp, "r");
+  if (!fp)
+    return -1;
+
+  if (pack_lock(bcache) < 0)
+  {
+    mutt_file_fclose(&fp);
+    return -1;
+  }
+
+  offset = lseek(pack->fd, 0, SEEK_END);
+  if ((offset < 0) || (pack_copy(pack->fd, fp, &length) < 0))
+  {
+    mutt_debug(1, "bcache: pack: can't write '%s': %s\n", id, strerror(errno));
+    if ((offset >= 0) && (ftruncate(pack->fd, offset) < 0))
+      mutt_debug(1, "bcache: pack: can't truncate %s\n", bcache->path);
+    goto done;
+  }
+
+  char line[LONG_STRING];
+  snprintf(line, sizeof(line), "+ %lld %lld %s", (long long) offset,
+           (long long) length, id);
+  if (pack_append(pack, line) < 0)
+    goto done;
+
+  mutt_file_touch_atime(pack->fd);
+  rc = 0;
+
+done:
+  pack_unlock(bcache);
+  mutt_file_fclose(&fp);
+  if (rc == 0)
+  {
+    unlink(tmp);
+    bcache_charge(length);
+  }
+  return rc;
+}
+
+/**
+ * pack_del - Delete a body from a pack
+ * @param bcache Body cache
+ * @param id     Id of the body
+ * @retval  0 Success
+ * @retval -1 Error, or the body isn't in the pack
+ *
+ * The space is only reclaimed when the pack is compacted.
+ */
+static int pack_del(struct BodyCache *bcache, const char *id)
+{
+  struct BcachePack *pack = bcache->pack;
+  int rc = -1;
+
+  if (!pack_find(bcache, id) || (pack_lock(bcache) < 0))
+    return -1;
+
+  if (mutt_hash_find(pack->index, id))
+  {
+    char line[LONG_STRING];
+    snprintf(line, sizeof(line), "- %s", id);
+    rc = pack_append(pack, line);
+  }
+
+  pack_unlock(bcache);
+  return rc;
+}
+
+/**
+ * pack_compact - Copy the bodies still in use to a new pack
+ * @param bcache Body cache
+ *
+ * Only done when more than half the pack has been deleted.
+ */
+static void pack_compact(struct BodyCache *bcache)
+{
+  struct BcachePack *pack = bcache->pack;
+  char oldpath[PATH_MAX];
+  char newpath[PATH_MAX];
+  char logpath[PATH_MAX];
+  char tmplog[PATH_MAX];
+  struct HashWalkState state = { 0 };
+  struct HashElem *elem = NULL;
+  FILE *fplog = NULL;
+  int fd = -1;
+  off_t offset = 0;
+  char buf[BUFSIZ];
+
+  if (pack_lock(bcache) < 0)
+    return;
+
+  off_t dead = pack->dead;
+  if ((dead < BCACHE_PACK_MIN_DEAD) || (dead < pack->live))
+    goto done;
+
+  mutt_debug(2, "bcache: pack: compacting %s, %lld of %lld bytes unused\n",
+             bcache->path, (long long) dead, (long long) (dead + pack->live));
+
+  if ((pack_path(bcache, pack->gen, oldpath, sizeof(oldpath)) < 0) ||
+      (pack_path(bcache, pack->gen + 1, newpath, sizeof(newpath)) < 0) ||
+      (pack_path(bcache, 0, logpath, sizeof(logpath)) < 0) ||
+      (snprintf(tmplog, sizeof(tmplog), "%s.tmp", logpath) >= sizeof(tmplog)))
+  {
+    goto done;
+  }
+
+  fd = open(newpath, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+  fplog = mutt_file_fopen(tmplog, "w");
+  if ((fd < 0) || !fplog)
+    goto fail;
+
+  fprintf(fplog, "%s %u\n", BCACHE_PACK_MAGIC, pack->gen + 1);
+
+  while ((elem = mutt_hash_walk(pack->index, &state)))
+  {
+    struct BcachePackEntry *e = elem->data;
+    off_t copied = 0;
+
+    while (copied < e->length)
+    {
+      size_t want = MIN(sizeof(buf), (size_t)(e->length - copied));
+      ssize_t n = pread(pack->fd, buf, want, e->offset + copied);
+      if ((n <= 0) || (write(fd, buf, n) != n))
+        goto fail;
+      copied += n;
+    }
+
+    fprintf(fplog, "+ %lld %lld %s\n", (long long) offset, (long long) e->length,
+            elem->key.strkey);
+    offset += e->length;
+  }
+
+  if ((mutt_file_fsync_close(&fplog) != 0) || (fsync(fd) != 0) || (close(fd) != 0))
+  {
+    fd = -1;
+    goto fail;
+  }
+  fd = -1;
+
+  /* the new log names the new pack, so switching the log switches both */
+  if (rename(tmplog, logpath) < 0)
+    goto fail;
+  unlink(oldpath);
+
+  pack_unlock(bcache);
+  pack_close(pack);
+  bcache_charge(-dead);
+  return;
+
+fail:
+  mutt_debug(1, "bcache: pack: compacting %s failed: %s\n", bcache->path, strerror(errno));
+  mutt_file_fclose(&fplog);
+  if (fd >= 0)
+    close(fd);
+  unlink(tmplog);
+  unlink(newpath);
+
+done:
+  pack_unlock(bcache);
+}
+
+#ifdef HAVE_FOPENCOOKIE
+/**
+ * struct PackBody - A body being read from a pack
+ */
+struct PackBody
+{
+  int fd;
+  off_t offset; /**< start of the body in the pack */
+  off_t length;
+  off_t pos;    /**< position within the body */
+};
+
+/**
+ * pack_body_read - Read from a body in a pack, fopencookie(3) callback
+ */
+static ssize_t pack_body_read(void *cookie, char *buf, size_t size)
+{
+  struct PackBody *pb = cookie;
+
+  if (pb->pos >= pb->length)
+    return 0;
+
+  size = MIN(size, (size_t)(pb->length - pb->pos));
+  ssize_t n = pread(pb->fd, buf, size, pb->offset + pb->pos);
+  if (n > 0)
+    pb->pos += n;
+  return n;
+}
+
+/**
+ * pack_body_seek - Seek in a body in a pack, fopencookie(3) callback
+ */
+static int pack_body_seek(void *cookie, off64_t *offset, int whence)
+{
+  struct PackBody *pb = cookie;
+  off_t target;
+
+  switch (whence)
+  {
+    case SEEK_SET:
+      target = *offset;
+      break;
+    case SEEK_CUR:
+      target = pb->pos + *offset;
+      break;
+    case SEEK_END:
+      target = pb->length + *offset;
+      break;
+    default:
+      errno = EINVAL;
+      return -1;
+  }
+
+  if (target < 0)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  pb->pos = target;
+  *offset = target;
+  return 0;
+}
+
+/**
+ * pack_body_close - Close a body in a pack, fopencookie(3) callback
+ */
+static int pack_body_close(void *cookie)
+{
+  struct PackBody *pb = cookie;
+  close(pb->fd);
+  FREE(&pb);
+  return 0;
+}
+#endif
+
+/**
+ * pack_get - Open a body in a pack
+ * @param bcache Body cache
+ * @param id     Id of the body
+ * @retval ptr  Read-only stream of the body
+ * @retval NULL Not in the cache
+ *
+ * The body is read straight from the pack; the stream keeps its own handle,
+ * so it outlives the cache.
+ */
+static FILE *pack_get(struct BodyCache *bcache, const char *id)
 {
+  struct BcachePackEntry *e = pack_find(bcache, id);
+  if (!e)
+    return NULL;
+
+  mutt_file_touch_atime(bcache->pack->fd);
+
+#ifdef HAVE_FOPENCOOKIE
+  static const cookie_io_functions_t funcs = {
+    .read = pack_body_read,
+    .write = NULL,
+    .seek = pack_body_seek,
+    .close = pack_body_close,
+  };
+
+  struct PackBody *pb = mutt_mem_calloc(1, sizeof(struct PackBody));
+  pb->fd = dup(bcache->pack->fd);
+  pb->offset = e->offset;
+  pb->length = e->length;
+
+  FILE *fp = (pb->fd >= 0) ? fopencookie(pb, "r", funcs) : NULL;
+  if (!fp)
+  {
+    if (pb->fd >= 0)
+      close(pb->fd);
+    FREE(&pb);
+  }
+  return fp;
+#else
+  /* no way to read the pack in place, so take a copy */
   char path[_POSIX_PATH_MAX];
-  char newpath[_POSIX_PATH_MAX];
+  char buf[BUFSIZ];
+  off_t done = 0;
+
+  mutt_mktemp(path, sizeof(path));
+  FILE *fp = mutt_file_fopen(path, "w+");
+  if (!fp)
+    return NULL;
+  unlink(path);
+
+  while (done < e->length)
+  {
+    size_t want = MIN(sizeof(buf), (size_t)(e->length - done));
+    ssize_t n = pread(bcache->pack->fd, buf, want, e->offset + done);
+    if ((n <= 0) || (fwrite(buf, 1, n, fp) != (size_t) n))
+    {
+      mutt_file_fclose(&fp);
+      return NULL;
+    }
+    done += n;
+  }
+  rewind(fp);
+  return fp;
+#endif
+}
+
+/**
+ * pack_list - List the bodies in a pack
+ * @param bcache  Body cache
+ * @param want_id Callback function called for each body
+ * @param data    Data to pass to the callback function
+ * @retval -1  on failure
+ * @retval >=0 count of matching items
+ *
+ * The ids are copied first, so the callback may delete bodies.
+ */
+static int pack_list(struct BodyCache *bcache,
+                     int (*want_id)(const char *id, struct BodyCache *bcache, void *data),
+                     void *data)
+{
+  struct BcachePack *pack = bcache->pack;
+  struct HashWalkState state = { 0 };
+  struct HashElem *elem = NULL;
+  char **ids = NULL;
+  size_t count = 0, max = 0;
+  int rc = 0;
+  bool stop = false;
+
+  if (pack_refresh(bcache) < 0)
+    return -1;
+  if (pack->fd < 0)
+    return 0;
+
+  while ((elem = mutt_hash_walk(pack->index, &state)))
+  {
+    if (count == max)
+    {
+      max += 256;
+      mutt_mem_realloc(&ids, max * sizeof(char *));
+    }
+    ids[count++] = mutt_str_strdup(elem->key.strkey);
+  }
+
+  for (size_t i = 0; i < count; i++)
+  {
+    if (!stop)
+    {
+      mutt_debug(3, "bcache: list: pack: '%s', id :'%s'\n", bcache->path, ids[i]);
+      if (want_id && (want_id(ids[i], bcache, data) != 0))
+        stop = true;
+      else
+        rc++;
+    }
+    FREE(&ids[i]);
+  }
+  FREE(&ids);
+
+  return rc;
+}
+
+static int mutt_bcache_move(struct BodyCache *bcache, const char *id, const char *newid)
+{
+  char path[PATH_MAX];
+  char newpath[PATH_MAX];
 
   if (!bcache || !id || !*id || !newid || !*newid)
     return -1;
 
-  snprintf(path, sizeof(path), "%s%s", bcache->path, id);
-  snprintf(newpath, sizeof(newpath), "%s%s", bcache->path, newid);
+  if ((snprintf(path, sizeof(path), "%s%s", bcache->path, id) >= sizeof(path)) ||
+      (snprintf(newpath, sizeof(newpath), "%s%s", bcache->path, newid) >= sizeof(newpath)))
+  {
+    return -1;
+  }
 
   mutt_debug(3, "bcache: mv: '%s' '%s'\n", path, newpath);
 
@@ -116,6 +1297,13 @@ struct BodyCache *mutt_bcache_open(struct Account *account, const char *mailbox)
     goto bail;
   bcache->pathlen = mutt_str_strlen(bcache->path);
 
+  if (option(OPT_MESSAGE_CACHE_PACKED))
+  {
+    bcache->pack = mutt_mem_calloc(1, sizeof(struct BcachePack));
+    bcache->pack->fd = -1;
+    pack_forget(bcache->pack);
+  }
+
   return bcache;
 
 bail:
@@ -128,6 +1316,17 @@ void mutt_bcache_close(struct BodyCache **bcache)
 {
   if (!bcache || !*bcache)
     return;
+
+  struct BcachePack *pack = (*bcache)->pack;
+  if (pack)
+  {
+    if (pack->log && (pack->dead >= BCACHE_PACK_MIN_DEAD) && (pack->dead >= pack->live))
+      pack_compact(*bcache);
+    pack_close(pack);
+    mutt_hash_destroy(&pack->index, pack_entry_free);
+    FREE(&(*bcache)->pack);
+  }
+
   FREE(bcache);
 }
 
@@ -139,12 +1338,24 @@ FILE *mutt_bcache_get(struct BodyCache *bcache, const char *id)
   if (!id || !*id || !bcache)
     return NULL;
 
+  if (bcache->pack)
+  {
+    fp = pack_get(bcache, id);
+    mutt_debug(3, "bcache: get: pack '%s', id '%s': %s\n", bcache->path, id,
+               fp == NULL ? "no" : "yes");
+    return fp;
+  }
+
   path[0] = '\0';
   mutt_str_strncat(path, sizeof(path), bcache->path, bcache->pathlen);
   mutt_str_strncat(path, sizeof(path), id, mutt_str_strlen(id));
 
   fp = mutt_file_fopen(path, "r");
 
+  /* eviction relies on the access time, even on noatime mounts */
+  if (fp)
+    mutt_file_touch_atime(fileno(fp));
+
   mutt_debug(3, "bcache: get: '%s': %s\n", path, fp == NULL ? "no" : "yes");
 
   return fp;
@@ -188,11 +1399,36 @@ FILE *mutt_bcache_put(struct BodyCache *bcache, const char *id)
 
 int mutt_bcache_commit(struct BodyCache *bcache, const char *id)
 {
-  char tmpid[_POSIX_PATH_MAX];
+  char tmpid[PATH_MAX];
+  char path[PATH_MAX];
+  struct stat st;
+  off_t size = 0;
+
+  if (!id || !*id || !bcache)
+    return -1;
+
+  if ((snprintf(tmpid, sizeof(tmpid), "%s.tmp", id) >= sizeof(tmpid)) ||
+      (snprintf(path, sizeof(path), "%s%s", bcache->path, tmpid) >= sizeof(path)))
+  {
+    mutt_error(_("Path too long: %s%s.tmp"), bcache->path, id);
+    return -1;
+  }
 
-  snprintf(tmpid, sizeof(tmpid), "%s.tmp", id);
+  if (bcache->pack)
+    return pack_commit(bcache, id, path);
 
-  return mutt_bcache_move(bcache, tmpid, id);
+  if (stat(path, &st) == 0)
+  {
+    size = st.st_size;
+    if (option(OPT_MESSAGE_CACHE_DEDUP) && (size > 0) && bcache_dedup(path, &st))
+      size = 0;
+  }
+
+  int rc = mutt_bcache_move(bcache, tmpid, id);
+  if (rc == 0)
+    bcache_charge(size);
+
+  return rc;
 }
 
 int mutt_bcache_del(struct BodyCache *bcache, const char *id)
@@ -202,13 +1438,39 @@ int mutt_bcache_del(struct BodyCache *bcache, const char *id)
   if (!id || !*id || !bcache)
     return -1;
 
+  if (bcache->pack)
+  {
+    mutt_debug(3, "bcache: del: pack '%s', id '%s'\n", bcache->path, id);
+    return pack_del(bcache, id);
+  }
+
   path[0] = '\0';
   mutt_str_strncat(path, sizeof(path), bcache->path, bcache->pathlen);
   mutt_str_strncat(path, sizeof(path), id, mutt_str_strlen(id));
 
   mutt_debug(3, "bcache: del: '%s'\n", path);
 
-  return unlink(path);
+  struct stat st;
+  if (lstat(path, &st) < 0)
+    return -1;
+
+  /* drop the copy in the objects directory once nothing else shares it */
+  if (option(OPT_MESSAGE_CACHE_DEDUP) && (st.st_nlink == 2))
+  {
+    char obj[PATH_MAX];
+    struct stat ost;
+    if ((bcache_object_path(path, obj, sizeof(obj)) == 0) && (lstat(obj, &ost) == 0) &&
+        (ost.st_dev == st.st_dev) && (ost.st_ino == st.st_ino) && (unlink(obj) == 0))
+    {
+      st.st_nlink--;
+    }
+  }
+
+  int rc = unlink(path);
+  if ((rc == 0) && (st.st_nlink == 1))
+    bcache_charge(-st.st_size);
+
+  return rc;
 }
 
 int mutt_bcache_exists(struct BodyCache *bcache, const char *id)
@@ -220,6 +1482,15 @@ int mutt_bcache_exists(struct BodyCache *bcache, const char *id)
   if (!id || !*id || !bcache)
     return -1;
 
+  if (bcache->pack)
+  {
+    struct BcachePackEntry *e = pack_find(bcache, id);
+    rc = (e && (e->length != 0)) ? 0 : -1;
+    mutt_debug(3, "bcache: exists: pack '%s', id '%s': %s\n", bcache->path, id,
+               rc == 0 ? "yes" : "no");
+    return rc;
+  }
+
   path[0] = '\0';
   mutt_str_strncat(path, sizeof(path), bcache->path, bcache->pathlen);
   mutt_str_strncat(path, sizeof(path), id, mutt_str_strlen(id));
@@ -242,6 +1513,13 @@ int mutt_bcache_list(struct BodyCache *bcache,
   struct dirent *de = NULL;
   int rc = -1;
 
+  if (bcache && bcache->pack)
+  {
+    rc = pack_list(bcache, want_id, data);
+    mutt_debug(3, "bcache: list: did %d entries\n", rc);
+    return rc;
+  }
+
   if (!bcache || !(d = opendir(bcache->path)))
     goto out;
 
@@ -56,6 +56,9 @@ void mutt_bcache_close(struct BodyCache **bcache);
  * @param id     Per-mailbox unique identifier for the message
  * @retval FILE* on success
  * @retval NULL  on failure
+ *
+ * If $message_cache_packed is set, the stream reads from the middle of a
+ * pack, so it has no file descriptor of its own.
  */
 FILE *mutt_bcache_get(struct BodyCache *bcache, const char *id);
 
@@ -77,6 +80,10 @@ FILE *mutt_bcache_put(struct BodyCache *bcache, const char *id);
  * @param id     Per-mailbox unique identifier for the message
  * @retval 0 on success
  * @retval -1 on failure
+ *
+ * The file must have been flushed: if $message_cache_dedup is set, its
+ * contents are compared with the rest of the cache.  Committing may evict
+ * old entries to keep the cache within $message_cache_size.
  */
 int mutt_bcache_commit(struct BodyCache *bcache, const char *id);
 
@@ -26,6 +26,7 @@
 #include <unistd.h>
 #include "mutt/debug.h"
 #include "mutt/memory.h"
+#include "mutt/pool.h"
 #include "mutt/string2.h"
 #include "body.h"
 #include "header.h"
@@ -35,7 +36,24 @@
 
 struct Body *mutt_new_body(void)
 {
-  struct Body *p = mutt_mem_calloc(1, sizeof(struct Body));
+  return mutt_new_pooled_body(NULL);
+}
+
+/**
+ * mutt_new_pooled_body - Create a new Body in a mailbox's storage
+ * @param pool Storage to use, NULL to malloc the Body
+ * @retval ptr New Body
+ */
+struct Body *mutt_new_pooled_body(struct Pool *pool)
+{
+  struct Body *p = NULL;
+  if (pool)
+  {
+    p = mutt_pool_alloc(pool);
+    p->pool = pool;
+  }
+  else
+    p = mutt_mem_calloc(1, sizeof(struct Body));
 
   p->disposition = DISPATTACH;
   p->use_disp = true;
@@ -78,6 +96,7 @@ int mutt_copy_body(FILE *fp, struct Body **tgt, struct Body *src)
   memcpy(b, src, sizeof(struct Body));
   b->parts = NULL;
   b->next = NULL;
+  b->pool = NULL;
 
   b->filename = mutt_str_strdup(tmp);
   b->use_disp = use_disp;
@@ -155,7 +174,10 @@ void mutt_free_body(struct Body **p)
     if (b->parts)
       mutt_free_body(&b->parts);
 
-    FREE(&b);
+    if (b->pool)
+      mutt_pool_free(b->pool, b);
+    else
+      FREE(&b);
   }
 
   *p = 0;
@@ -96,9 +96,11 @@ struct Body
   bool collapsed : 1;           /**< used by recvattach */
   bool attach_qualifies : 1;
 
+  struct Pool *pool;            /**< storage this Body came from, NULL if malloc'd */
 };
 
 struct Body *mutt_new_body(void);
+struct Body *mutt_new_pooled_body(struct Pool *pool);
 int mutt_copy_body(FILE *fp, struct Body **tgt, struct Body *src);
 void mutt_free_body(struct Body **p);
 
@@ -1221,6 +1221,7 @@ void mutt_select_file(char *f, size_t flen, int flags, char ***files, int *numfi
           {
             case MUTT_MBOX:
             case MUTT_MMDF:
+            case MUTT_ZMBOX:
             case MUTT_MH:
             case MUTT_MAILDIR:
             case MUTT_IMAP:
@@ -24,10 +24,13 @@
 #include "config.h"
 #include <dirent.h>
 #include <limits.h>
+#include <poll.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <utime.h>
 #include "mutt/mutt.h"
 #include "mutt.h"
@@ -51,6 +54,12 @@
 #ifdef USE_NOTMUCH
 #include "mutt_notmuch.h"
 #endif
+#ifdef USE_INOTIFY
+#include "monitor.h"
+#endif
+#ifdef USE_HCACHE
+#include "hcache/hcache.h"
+#endif
 
 static time_t BuffyTime = 0; /**< last time we started checking for mail */
 static time_t BuffyStatsTime = 0; /**< last time we check performed mail_check_stats */
@@ -143,7 +152,7 @@ static int test_new_folder(const char *path)
 
   typ = mx_get_magic(path);
 
-  if (typ != MUTT_MBOX && typ != MUTT_MMDF)
+  if (typ != MUTT_MBOX && typ != MUTT_MMDF && typ != MUTT_ZMBOX)
     return 0;
 
   if ((f = fopen(path, "rb")))
@@ -167,14 +176,23 @@ static struct Buffy *buffy_new(const char *path)
   mutt_str_strfcpy(buffy->realpath, r ? rp : path, sizeof(buffy->realpath));
   buffy->next = NULL;
   buffy->magic = 0;
+  buffy->dirty = true;
 
   return buffy;
 }
 
+static void maildir_stats_free(struct MaildirStats **ptr);
+
 static void buffy_free(struct Buffy **mailbox)
 {
   if (mailbox && *mailbox)
+  {
+#ifdef USE_INOTIFY
+    mutt_monitor_remove(*mailbox);
+#endif
+    maildir_stats_free(&(*mailbox)->maildir_stats);
     FREE(&(*mailbox)->desc);
+  }
   FREE(mailbox);
 }
 
@@ -265,6 +283,320 @@ static int buffy_maildir_check_dir(struct Buffy *mailbox, const char *dir_name,
   return rc;
 }
 
+/* Flags of a maildir message, taken from its filename */
+#define MD_FLAGGED (1 << 0)
+#define MD_SEEN    (1 << 1)
+#define MD_TRASHED (1 << 2)
+
+/**
+ * struct MaildirCounts - Counts of the messages in a maildir subdirectory
+ *
+ * This is what gets saved in the header cache.
+ */
+struct MaildirCounts
+{
+  time_t mtime;   /**< mtime of the directory when it was counted */
+  time_t counted; /**< when the directory was counted */
+  int count;      /**< number of messages, not counting trashed ones */
+  int unread;     /**< number of unread messages */
+  int flagged;    /**< number of flagged messages */
+};
+
+/**
+ * struct MaildirDir - Cached counts of a maildir subdirectory
+ */
+struct MaildirDir
+{
+  struct MaildirCounts c;
+  struct Hash *names; /**< filename -> flags, NULL if only the counts are known */
+  bool valid;         /**< the counts can be used */
+  bool synced;        /**< the directory is watched, the counts are kept up to date */
+};
+
+/**
+ * struct MaildirStats - Cached counts of a maildir mailbox
+ *
+ * The counts are kept up to date with the files that have been added or
+ * removed since the directory was last read.  If the mailbox isn't being
+ * watched, the directory's mtime says if it needs reading again.
+ */
+struct MaildirStats
+{
+  struct MaildirDir dir[2]; /**< new/ and cur/ */
+};
+
+static const char *const MaildirDirs[2] = { "new", "cur" };
+
+static void maildir_stats_free(struct MaildirStats **ptr)
+{
+  if (!ptr || !*ptr)
+    return;
+
+  for (int i = 0; i < 2; i++)
+    mutt_hash_destroy(&(*ptr)->dir[i].names, NULL);
+  FREE(ptr);
+}
+
+/**
+ * maildir_name_flags - Get the flags from a maildir filename
+ * @param name Filename
+ * @retval num Flags, e.g. #MD_SEEN
+ */
+static int maildir_name_flags(const char *name)
+{
+  const char *p = strstr(name, ":2,");
+  if (!p)
+    return 0;
+
+  int flags = 0;
+  for (p += 3; *p; p++)
+  {
+    if (*p == 'F')
+      flags |= MD_FLAGGED;
+    else if (*p == 'S')
+      flags |= MD_SEEN;
+    else if (*p == 'T')
+      flags |= MD_TRASHED;
+  }
+  return flags;
+}
+
+/**
+ * maildir_dir_count - Add or remove a message from the counts
+ * @param d     Maildir subdirectory
+ * @param flags Flags of the message, e.g. #MD_SEEN
+ * @param delta 1 to add the message, -1 to remove it
+ */
+static void maildir_dir_count(struct MaildirDir *d, int flags, int delta)
+{
+  if (flags & MD_TRASHED)
+    return;
+
+  d->c.count += delta;
+  if (!(flags & MD_SEEN))
+    d->c.unread += delta;
+  if (flags & MD_FLAGGED)
+    d->c.flagged += delta;
+}
+
+/**
+ * maildir_dir_add - A file has appeared in a maildir subdirectory
+ * @param d    Maildir subdirectory
+ * @param name Filename
+ *
+ * Adding a file that is already known does nothing, so a file can be seen
+ * both by readdir() and by the monitor.
+ */
+static void maildir_dir_add(struct MaildirDir *d, const char *name)
+{
+  if (*name == '.')
+    return;
+
+  int flags = maildir_name_flags(name);
+  struct HashElem *e = mutt_hash_find_elem(d->names, name);
+  if (e)
+  {
+    maildir_dir_count(d, (int) (intptr_t) e->data, -1);
+    e->data = (void *) (intptr_t) flags;
+  }
+  else
+    mutt_hash_insert(d->names, name, (void *) (intptr_t) flags);
+
+  maildir_dir_count(d, flags, 1);
+}
+
+/**
+ * maildir_dir_remove - A file has gone from a maildir subdirectory
+ * @param d    Maildir subdirectory
+ * @param name Filename
+ */
+static void maildir_dir_remove(struct MaildirDir *d, const char *name)
+{
+  struct HashElem *e = mutt_hash_find_elem(d->names, name);
+  if (!e)
+    return;
+
+  maildir_dir_count(d, (int) (intptr_t) e->data, -1);
+  mutt_hash_delete(d->names, name, NULL, NULL);
+}
+
+/**
+ * maildir_dir_read - Count the messages in a maildir subdirectory
+ * @param d     Maildir subdirectory
+ * @param path  Path to the subdirectory
+ * @param mtime mtime of the directory, taken before reading it
+ * @retval true Success
+ */
+static bool maildir_dir_read(struct MaildirDir *d, const char *path, time_t mtime)
+{
+  DIR *dirp = opendir(path);
+  if (!dirp)
+    return false;
+
+  int size = d->names ? d->c.count : 0;
+  mutt_hash_destroy(&d->names, NULL);
+  d->names = mutt_hash_create(MAX(size, 64), MUTT_HASH_STRDUP_KEYS);
+  memset(&d->c, 0, sizeof(d->c));
+  d->c.mtime = mtime;
+  d->c.counted = time(NULL);
+
+  struct dirent *de = NULL;
+  while ((de = readdir(dirp)) != NULL)
+    maildir_dir_add(d, de->d_name);
+
+  closedir(dirp);
+  mutt_debug(3, "%s: %d messages\n", path, d->c.count);
+  d->valid = true;
+  return true;
+}
+
+#ifdef USE_HCACHE
+/**
+ * maildir_stats_fetch - Get the counts of a maildir from the header cache
+ * @param mailbox Mailbox
+ *
+ * Only the counts are saved, so they have to be checked against the mtimes
+ * of the directories before they are used.
+ */
+static void maildir_stats_fetch(struct Buffy *mailbox)
+{
+  header_cache_t *hc = mutt_hcache_open(HeaderCache, mailbox->path, NULL);
+  if (!hc)
+    return;
+
+  struct MaildirCounts *counts = mutt_hcache_fetch_raw(hc, "/MAILDIRSTATS", 13);
+  if (counts)
+  {
+    for (int i = 0; i < 2; i++)
+    {
+      mailbox->maildir_stats->dir[i].c = counts[i];
+      mailbox->maildir_stats->dir[i].valid = true;
+    }
+    mutt_hcache_free(hc, (void **) &counts);
+  }
+  mutt_hcache_close(hc);
+}
+
+/**
+ * maildir_stats_store - Save the counts of a maildir in the header cache
+ * @param mailbox Mailbox
+ */
+static void maildir_stats_store(struct Buffy *mailbox)
+{
+  header_cache_t *hc = mutt_hcache_open(HeaderCache, mailbox->path, NULL);
+  if (!hc)
+    return;
+
+  struct MaildirCounts counts[2];
+  for (int i = 0; i < 2; i++)
+    counts[i] = mailbox->maildir_stats->dir[i].c;
+  mutt_hcache_store_raw(hc, "/MAILDIRSTATS", 13, counts, sizeof(counts));
+  mutt_hcache_close(hc);
+}
+#endif
+
+/**
+ * buffy_maildir_stats - Update the message counts of a maildir mailbox
+ * @param mailbox Mailbox to check
+ * @retval true Success
+ *
+ * A directory is only read if it has changed since it was last counted and
+ * its changes haven't been seen by the monitor.
+ */
+static bool buffy_maildir_stats(struct Buffy *mailbox)
+{
+  char path[PATH_MAX];
+  struct stat sb;
+#ifdef USE_HCACHE
+  bool reread = false;
+#endif
+
+  if (!mailbox->maildir_stats)
+  {
+    mailbox->maildir_stats = mutt_mem_calloc(1, sizeof(struct MaildirStats));
+#ifdef USE_HCACHE
+    maildir_stats_fetch(mailbox);
+#endif
+  }
+
+  for (int i = 0; i < 2; i++)
+  {
+    struct MaildirDir *d = &mailbox->maildir_stats->dir[i];
+
+    if (!mailbox->watched)
+      d->synced = false;
+    if (d->valid && d->synced)
+      continue;
+
+    snprintf(path, sizeof(path), "%s/%s", mailbox->path, MaildirDirs[i]);
+    if (stat(path, &sb) != 0)
+      return false;
+
+    /* a change in the same second as the count may not have been seen */
+    if (!d->valid || (sb.st_mtime != d->c.mtime) || (d->c.mtime >= d->c.counted))
+    {
+      if (!maildir_dir_read(d, path, sb.st_mtime))
+        return false;
+#ifdef USE_HCACHE
+      reread = true;
+#endif
+    }
+
+    /* from now on, the monitor will tell us about any changes */
+    d->synced = mailbox->watched;
+  }
+
+#ifdef USE_HCACHE
+  if (reread)
+    maildir_stats_store(mailbox);
+#endif
+
+  struct MaildirDir *dirs = mailbox->maildir_stats->dir;
+  mailbox->msg_count = dirs[0].c.count + dirs[1].c.count;
+  mailbox->msg_unread = dirs[0].c.unread + dirs[1].c.unread;
+  mailbox->msg_flagged = dirs[0].c.flagged + dirs[1].c.flagged;
+  return true;
+}
+
+/**
+ * mutt_buffy_maildir_event - A file in a watched maildir has changed
+ * @param b     Mailbox
+ * @param dir   Subdirectory, "new" or "cur"
+ * @param name  Filename, NULL if some changes have been missed
+ * @param added true if the file has appeared, false if it has gone
+ */
+void mutt_buffy_maildir_event(struct Buffy *b, const char *dir, const char *name, bool added)
+{
+  if (!b || !b->maildir_stats)
+    return;
+
+  for (int i = 0; i < 2; i++)
+  {
+    struct MaildirDir *d = &b->maildir_stats->dir[i];
+
+    if (!name)
+    {
+      d->valid = false;
+      continue;
+    }
+
+    if (!d->valid || (mutt_str_strcmp(dir, MaildirDirs[i]) != 0))
+      continue;
+
+    /* the counts came from the header cache, the files aren't known */
+    if (!d->names)
+    {
+      d->valid = false;
+      continue;
+    }
+
+    if (added)
+      maildir_dir_add(d, name);
+    else
+      maildir_dir_remove(d, name);
+  }
+}
+
 /**
  * buffy_maildir_check - Check for new mail in a maildir mailbox
  * @param mailbox     Mailbox to check
@@ -278,9 +610,27 @@ static int buffy_maildir_check(struct Buffy *mailbox, bool check_stats)
 
   if (check_stats)
   {
-    mailbox->msg_count = 0;
-    mailbox->msg_unread = 0;
-    mailbox->msg_flagged = 0;
+    if (buffy_maildir_stats(mailbox))
+    {
+      /* the new mail can be found in the counts, unless it has to be
+       * compared with the last visit */
+      if (!option(OPT_MAIL_CHECK_RECENT))
+      {
+        struct MaildirDir *dirs = mailbox->maildir_stats->dir;
+        rc = (dirs[0].c.unread > 0) ||
+             (option(OPT_MAILDIR_CHECK_CUR) && (dirs[1].c.unread > 0));
+        if (rc)
+          mailbox->new = true;
+        return rc;
+      }
+      check_stats = false;
+    }
+    else
+    {
+      mailbox->msg_count = 0;
+      mailbox->msg_unread = 0;
+      mailbox->msg_flagged = 0;
+    }
   }
 
   rc = buffy_maildir_check_dir(mailbox, "new", check_new, check_stats);
@@ -410,18 +760,16 @@ static void buffy_check(struct Buffy *tmp, struct stat *contex_sb, bool check_st
     {
       case MUTT_MBOX:
       case MUTT_MMDF:
-        if (buffy_mbox_check(tmp, &sb, check_stats) > 0)
-          BuffyCount++;
+      case MUTT_ZMBOX:
+        buffy_mbox_check(tmp, &sb, check_stats);
         break;
 
       case MUTT_MAILDIR:
-        if (buffy_maildir_check(tmp, check_stats) > 0)
-          BuffyCount++;
+        buffy_maildir_check(tmp, check_stats);
         break;
 
       case MUTT_MH:
-        if (mh_buffy(tmp, check_stats))
-          BuffyCount++;
+        mh_buffy(tmp, check_stats);
         break;
 #ifdef USE_NOTMUCH
       case MUTT_NOTMUCH:
@@ -430,10 +778,7 @@ static void buffy_check(struct Buffy *tmp, struct stat *contex_sb, bool check_st
         tmp->msg_flagged = 0;
         nm_nonctx_get_count(tmp->path, &tmp->msg_count, &tmp->msg_unread);
         if (tmp->msg_unread > 0)
-        {
-          BuffyCount++;
           tmp->new = true;
-        }
         break;
 #endif
     }
@@ -446,10 +791,20 @@ static void buffy_check(struct Buffy *tmp, struct stat *contex_sb, bool check_st
       (orig_unread != tmp->msg_unread) || (orig_flagged != tmp->msg_flagged))
     mutt_set_current_menu_redraw(REDRAW_SIDEBAR);
 #endif
+}
+
+/**
+ * buffy_count - Count a mailbox with new mail
+ * @param b Mailbox
+ */
+static void buffy_count(struct Buffy *b)
+{
+  if (b->new)
+    BuffyCount++;
 
-  if (!tmp->new)
-    tmp->notified = false;
-  else if (!tmp->notified)
+  if (!b->new)
+    b->notified = false;
+  else if (!b->notified)
     BuffyNotify++;
 }
 
@@ -683,17 +1038,43 @@ int mutt_parse_unmailboxes(struct Buffer *path, struct Buffer *s,
   return 0;
 }
 
+/**
+ * buffy_key_pending - Has the user typed something?
+ * @retval true If there's a key waiting to be read
+ */
+static bool buffy_key_pending(void)
+{
+  struct pollfd fds = { .fd = 0, .events = POLLIN };
+
+  if (option(OPT_NO_CURSES) || !isatty(0))
+    return false;
+
+  return (poll(&fds, 1, 0) > 0) && (fds.revents & POLLIN);
+}
+
 /**
  * mutt_buffy_check - Check all Incoming for new mail
  *
  * Check all Incoming for new mail and total/new/flagged messages
  * force: if true, ignore MailCheck and check for new mail anyway
+ *
+ * Unless force is set, the checking stops as soon as the user presses a key,
+ * so the UI doesn't wait for it.  The next call carries on where it left off.
  */
 int mutt_buffy_check(bool force)
 {
+  static dev_t context_dev = 0;
+  static ino_t context_ino = 0;
+  static bool pending = false;       /* some mailboxes are waiting to be checked */
+  static bool pending_stats = false; /* and their stats are wanted */
+#ifdef USE_IMAP
+  static bool pending_imap = false;
+#endif
   struct stat contex_sb;
   time_t t;
   bool check_stats = false;
+  bool timed;
+  bool changed;
   contex_sb.st_dev = 0;
   contex_sb.st_ino = 0;
 
@@ -708,22 +1089,33 @@ int mutt_buffy_check(bool force)
     return 0;
 
   t = time(NULL);
-  if (!force && (t - BuffyTime < MailCheck))
+  timed = force || (t - BuffyTime >= MailCheck);
+#ifdef USE_INOTIFY
+  /* a watched mailbox has changed, check it now */
+  changed = MonitorFilesChanged;
+  MonitorFilesChanged = false;
+#else
+  changed = false;
+#endif
+  if (!timed && !changed && !pending)
     return BuffyCount;
 
-  if (option(OPT_MAIL_CHECK_STATS) && (t - BuffyStatsTime >= MailCheckStatsInterval))
+  if (option(OPT_MAIL_CHECK_STATS) && (timed || changed))
   {
-    check_stats = true;
-    BuffyStatsTime = t;
+    if (t - BuffyStatsTime >= MailCheckStatsInterval)
+    {
+      check_stats = true;
+      BuffyStatsTime = t;
+    }
+    else if (!timed)
+    {
+      /* only the mailboxes that have changed will be counted */
+      check_stats = true;
+    }
   }
 
-  BuffyTime = t;
-  BuffyCount = 0;
-  BuffyNotify = 0;
-
-#ifdef USE_IMAP
-  BuffyCount += imap_buffy_check(force, check_stats);
-#endif
+  if (timed)
+    BuffyTime = t;
 
   /* check device ID and serial number instead of comparing paths */
   if (!Context || Context->magic == MUTT_IMAP || Context->magic == MUTT_POP
@@ -736,10 +1128,76 @@ int mutt_buffy_check(bool force)
     contex_sb.st_ino = 0;
   }
 
-  for (struct Buffy *b = Incoming; b; b = b->next)
-    buffy_check(b, &contex_sb, check_stats);
+  /* the current folder isn't counted, so a change of folder affects two */
+  bool context_changed = (contex_sb.st_dev != context_dev) || (contex_sb.st_ino != context_ino);
+  context_dev = contex_sb.st_dev;
+  context_ino = contex_sb.st_ino;
+
+  /* decide which mailboxes need checking: a mailbox that is being watched
+   * only needs checking when it changes, the others are polled every
+   * $mail_check seconds */
+  if (timed || changed || context_changed)
+  {
+    for (struct Buffy *b = Incoming; b; b = b->next)
+    {
+      if (timed)
+        b->check_pending |= force || !b->watched || b->dirty || context_changed;
+      else
+        b->check_pending |= b->watched && (b->dirty || context_changed);
+    }
+    pending = true;
+    pending_stats |= check_stats;
+#ifdef USE_IMAP
+    pending_imap |= timed;
+#endif
+  }
+
+  struct Buffy *b = Incoming;
+  for (; pending && b; b = b->next)
+  {
+    if (!b->check_pending)
+      continue;
+
+    if (!force && buffy_key_pending())
+      break;
+
+    buffy_check(b, &contex_sb, pending_stats);
+    b->check_pending = false;
+    if (pending_stats || !option(OPT_MAIL_CHECK_STATS))
+      b->dirty = false;
+
+#ifdef USE_INOTIFY
+    if (!b->watched && ((b->magic == MUTT_MBOX) || (b->magic == MUTT_MMDF) ||
+                        (b->magic == MUTT_ZMBOX) || (b->magic == MUTT_MAILDIR) ||
+                        (b->magic == MUTT_MH)))
+    {
+      mutt_monitor_add(b);
+    }
+#endif
+  }
+  if (!b)
+    pending = false;
+
+#ifdef USE_IMAP
+  if (pending_imap && !pending && (force || !buffy_key_pending()))
+  {
+    imap_buffy_check(force, pending_stats);
+    pending_imap = false;
+  }
+  if (!pending && !pending_imap)
+#else
+  if (!pending)
+#endif
+  {
+    pending_stats = false;
+    BuffyDoneTime = BuffyTime;
+  }
+
+  BuffyCount = 0;
+  BuffyNotify = 0;
+  for (b = Incoming; b; b = b->next)
+    buffy_count(b);
 
-  BuffyDoneTime = BuffyTime;
   return BuffyCount;
 }
 
@@ -807,6 +1265,8 @@ void mutt_buffy_setnotified(const char *path)
 
   buffy->notified = true;
   time(&buffy->last_visited);
+  /* $mail_check_recent depends on the time of the last visit */
+  buffy->dirty = true;
 }
 
 int mutt_buffy_notify(void)
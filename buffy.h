@@ -29,6 +29,7 @@
 #include <time.h>
 #include "where.h"
 
+struct MaildirStats;
 struct stat;
 
 /* parameter to mutt_parse_mailboxes */
@@ -58,6 +59,10 @@ struct Buffy
   bool newly_created;        /**< mbox or mmdf just popped into existence */
   time_t last_visited;       /**< time of last exit from this mailbox */
   time_t stats_last_checked; /**< mtime of mailbox the last time stats where checked. */
+  bool watched;              /**< mailbox is being monitored, see monitor.c */
+  bool dirty;                /**< mailbox may have changed since it was last checked */
+  bool check_pending;        /**< mailbox is waiting to be checked */
+  struct MaildirStats *maildir_stats; /**< cached counts of a maildir */
 };
 
 WHERE struct Buffy *Incoming;
@@ -82,4 +87,6 @@ void mutt_buffy_setnotified(const char *path);
 
 bool mh_buffy(struct Buffy *mailbox, bool check_stats);
 
+void mutt_buffy_maildir_event(struct Buffy *b, const char *dir, const char *name, bool added);
+
 #endif /* _MUTT_BUFFY_H */
@@ -592,6 +592,27 @@ int mutt_parse_unmono(struct Buffer *buf, struct Buffer *s, unsigned long data,
   return parse_uncolor(buf, s, data, err, 0);
 }
 
+/**
+ * regex_is_anchored - Does a regex depend on where the search starts?
+ * @param s Regex
+ * @retval true If it uses ^ or a word boundary
+ *
+ * The pager searches from the middle of a line, with REG_NOTBOL, and the
+ * start of the search counts as a word boundary.  So a match found from
+ * an earlier position may not be the one found from a later one.
+ */
+static bool regex_is_anchored(const char *s)
+{
+  if (strchr(s, '^'))
+    return true;
+
+  for (const char *p = strchr(s, '\\'); p && p[1]; p = strchr(p + 2, '\\'))
+    if (strchr("<>bB`'", p[1]))
+      return true;
+
+  return false;
+}
+
 static int add_pattern(struct ColorLineHead *top, const char *s, int sensitive, int fg,
                        int bg, int attr, struct Buffer *err, int is_index, int match)
 {
@@ -660,6 +681,7 @@ static int add_pattern(struct ColorLineHead *top, const char *s, int sensitive,
       return -1;
     }
     tmp->pattern = mutt_str_strdup(s);
+    tmp->anchored = !is_index && regex_is_anchored(s);
     tmp->match = match;
 #ifdef HAVE_COLOR
     if (fg != -1 && bg != -1)
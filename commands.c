@@ -931,7 +931,8 @@ int mutt_save_message(struct Header *h, int delete, int decode, int decrypt)
       }
     }
 
-    need_buffy_cleanup = (ctx.magic == MUTT_MBOX || ctx.magic == MUTT_MMDF);
+    need_buffy_cleanup =
+        (ctx.magic == MUTT_MBOX || ctx.magic == MUTT_MMDF || ctx.magic == MUTT_ZMBOX);
 
     mx_close_mailbox(&ctx, NULL);
 
@@ -23,6 +23,7 @@
 
 #include "config.h"
 #include <limits.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/stat.h>
@@ -33,11 +34,15 @@
 #include "context.h"
 #include "format_flags.h"
 #include "globals.h"
+#include "header.h"
 #include "mailbox.h"
 #include "mutt_curses.h"
 #include "mx.h"
 #include "options.h"
 #include "protos.h"
+#ifdef USE_ZLIB
+#include "gzstream.h"
+#endif
 
 struct Header;
 
@@ -61,6 +66,7 @@ struct CompressInfo
   struct MxOps *child_ops; /**< callbacks of de-compressed file */
   int locked;              /**< if realpath is locked */
   FILE *lockfp;            /**< fp used for locking */
+  bool stream;             /**< read directly from the compressed file */
 };
 
 /**
@@ -435,6 +441,66 @@ static int execute_command(struct Context *ctx, const char *command, const char
   return rc;
 }
 
+#ifdef USE_ZLIB
+/**
+ * open_stream - Read a gzip-compressed mailbox without a temporary file
+ * @param ctx Mailbox to open
+ * @retval  0 Success
+ * @retval  1 The mailbox can't be streamed, use the open-hook instead
+ * @retval -1 Error
+ * @retval -2 Aborted by the user, the messages read so far are kept
+ *
+ * A read-only gzip mailbox is decompressed on the fly as it's read, so it
+ * doesn't need to be copied to /tmp first.  Only mbox and mmdf mailboxes can
+ * be read like this.
+ */
+static int open_stream(struct Context *ctx)
+{
+  struct CompressInfo *ci = ctx->compress_info;
+  LOFF_T size = 0;
+
+  if (!mutt_gz_is_gzip(ctx->path))
+    return 1;
+
+  if (!lock_realpath(ctx, 0))
+    return 1;
+  FILE *fp = mutt_gz_open(ctx->realpath, &size);
+  unlock_realpath(ctx);
+  if (!fp)
+    return 1;
+
+  int rc = mbox_open_stream(ctx, fp, size);
+  if (!ctx->fp)
+  {
+    /* not a mbox, so leave it to the open-hook */
+    mutt_file_fclose(&fp);
+    return 1;
+  }
+
+  if (rc == -1)
+  {
+    /* it's a mbox, but it couldn't be read, so there's no point in
+     * decompressing it again.  Forget what was parsed. */
+    mutt_hash_destroy(&ctx->id_hash, NULL);
+    mutt_hash_destroy(&ctx->subj_hash, NULL);
+    for (int i = 0; i < ctx->msgcount; i++)
+    {
+      mutt_label_hash_remove(ctx, ctx->hdrs[i]);
+      mutt_free_header(&ctx->hdrs[i]);
+    }
+    ctx->msgcount = 0;
+    mutt_file_fclose(&ctx->fp);
+    free_compress_info(ctx);
+    return -1;
+  }
+
+  ci->child_ops = mx_get_ops(ctx->magic);
+  ci->stream = true;
+  store_size(ctx);
+  return rc;
+}
+#endif
+
 /**
  * comp_open_mailbox - Open a compressed mailbox
  * @param ctx Mailbox to open
@@ -457,6 +523,15 @@ static int comp_open_mailbox(struct Context *ctx)
   if (!ci->close || (access(ctx->path, W_OK) != 0))
     ctx->readonly = true;
 
+#ifdef USE_ZLIB
+  if (ctx->readonly)
+  {
+    int rc = open_stream(ctx);
+    if (rc != 1)
+      return rc;
+  }
+#endif
+
   if (setup_paths(ctx) != 0)
     goto or_fail;
   store_size(ctx);
@@ -605,7 +680,11 @@ static int comp_close_mailbox(struct Context *ctx)
   ops->close(ctx);
 
   /* sync has already been called, so we only need to delete some files */
-  if (!ctx->append)
+  if (ci->stream)
+  {
+    /* there's no temporary file, ctx->path is the compressed file */
+  }
+  else if (!ctx->append)
   {
     /* If the file was removed, remove the compressed folder too */
     if ((access(ctx->path, F_OK) != 0) && !option(OPT_SAVE_EMPTY))
@@ -679,6 +758,10 @@ static int comp_check_mailbox(struct Context *ctx, int *index_hint)
   if (!ops)
     return -1;
 
+  /* changes to the compressed file aren't noticed until it's reopened */
+  if (ci->stream)
+    return 0;
+
   int size = get_size(ctx->realpath);
   if (size == ci->size)
     return 0;
@@ -68,7 +68,9 @@ struct Context
   struct Hash *id_hash;     /**< hash table by msg id */
   struct Hash *subj_hash;   /**< hash table by subject */
   struct Hash *thread_hash; /**< hash table for threading */
+  struct Pool *thread_pool; /**< storage for the MuttThread nodes */
   struct Hash *label_hash;  /**< hash table for x-labels */
+  struct HeaderPool *hdr_pool; /**< storage for the emails */
   int *v2r;                 /**< mapping from virtual to real msgno */
   int hdrmax;               /**< number of pointers in hdrs */
   int msgcount;             /**< number of messages in the mailbox */
@@ -93,6 +95,7 @@ struct Context
   bool append : 1;    /**< mailbox is opened in append mode */
   bool quiet : 1;     /**< inhibit status messages? */
   bool collapsed : 1; /**< are all threads collapsed? */
+  bool limit_dirty : 1; /**< some messages need re-checking against the limit */
   bool closing : 1;   /**< mailbox is being closed */
   bool peekonly : 1;  /**< just taking a glance, revert atime */
 
@@ -795,7 +795,7 @@ static int append_message(struct Context *dest, FILE *fpin, struct Context *src,
   msg = mx_open_new_message(dest, hdr, is_from(buf, NULL, 0, NULL) ? 0 : MUTT_ADD_FROM);
   if (!msg)
     return -1;
-  if (dest->magic == MUTT_MBOX || dest->magic == MUTT_MMDF)
+  if (dest->magic == MUTT_MBOX || dest->magic == MUTT_MMDF || dest->magic == MUTT_ZMBOX)
     chflags |= CH_FROM | CH_FORCE_FROM;
   chflags |= (dest->magic == MUTT_MAILDIR ? CH_NOSTATUS : CH_UPDATE);
   r = mutt_copy_message_fp(msg->fp, fpin, hdr, flags, chflags);
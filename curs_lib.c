@@ -61,6 +61,9 @@
 #ifdef USE_NOTMUCH
 #include "mutt_notmuch.h"
 #endif
+#ifdef USE_INOTIFY
+#include "monitor.h"
+#endif
 
 /* not possible to unget more than one char under some curses libs, and it
  * is impossible to unget function keys in SLang, so roll our own input
@@ -120,6 +123,47 @@ void mutt_need_hard_redraw(void)
   mutt_set_current_menu_redraw_full();
 }
 
+static int MuttGetchTimeout = -1; /**< timeout in ms for mutt_getch() */
+
+/**
+ * mutt_getch_timeout - Set the getch() timeout
+ * @param delay Timeout delay in ms
+ *
+ * As for timeout(3): 0 means non-blocking and a negative delay means block
+ * until a key is pressed.
+ */
+void mutt_getch_timeout(int delay)
+{
+  MuttGetchTimeout = delay;
+  timeout(delay);
+}
+
+/**
+ * mutt_input_pending - Is there input waiting to be read?
+ * @retval true If a key, or a macro, is waiting
+ *
+ * Input that curses has already read from the terminal is put back, so the
+ * next mutt_getch() still sees it.
+ */
+bool mutt_input_pending(void)
+{
+  if (UngetCount || (!option(OPT_IGNORE_MACRO_EVENTS) && MacroBufferCount))
+    return true;
+
+  if (option(OPT_NO_CURSES))
+    return false;
+
+  timeout(0);
+  int ch = getch();
+  timeout(MuttGetchTimeout);
+
+  if (ch == ERR)
+    return false;
+
+  ungetch(ch);
+  return true;
+}
+
 struct Event mutt_getch(void)
 {
   int ch;
@@ -135,12 +179,30 @@ struct Event mutt_getch(void)
   SigInt = 0;
 
   mutt_allow_interrupt(1);
+  ch = ERR;
+#ifdef USE_INOTIFY
+  bool woken = false;
+  if (MuttGetchTimeout > 0)
+  {
+    /* poll() can't see the input that curses has already buffered */
+    timeout(0);
+    ch = getch();
+    timeout(MuttGetchTimeout);
+    /* wake up early if a watched mailbox changes */
+    if (ch == ERR)
+      woken = (mutt_monitor_poll(MuttGetchTimeout) != 0);
+  }
+  if (!woken)
+#endif
+  {
+    if (ch == ERR)
+      ch = getch();
 #ifdef KEY_RESIZE
-  /* ncurses 4.2 sends this when the screen is resized */
-  ch = KEY_RESIZE;
-  while (ch == KEY_RESIZE)
+    /* ncurses 4.2 sends this when the screen is resized */
+    while (ch == KEY_RESIZE)
+      ch = getch();
 #endif /* KEY_RESIZE */
-    ch = getch();
+  }
   mutt_allow_interrupt(0);
 
   if (SigInt)
@@ -644,6 +706,7 @@ void mutt_reflow_windows(void)
     return;
 
   mutt_debug(2, "In mutt_reflow_windows\n");
+  mutt_menu_forget_rows();
 
   MuttStatusWindow->rows = 1;
   MuttStatusWindow->cols = COLS;
@@ -77,6 +77,9 @@
 #ifdef USE_NNTP
 #include "nntp.h"
 #endif
+#ifdef USE_INOTIFY
+#include "monitor.h"
+#endif
 
 static const char *No_mailbox_is_open = N_("No mailbox is open.");
 static const char *There_are_no_messages = N_("There are no messages.");
@@ -152,6 +155,70 @@ static const char *No_visible = N_("No visible messages.");
 static char *tsl = "\033]0;";
 static char *fsl = "\007";
 
+/* Generation of the cached index lines, see index_make_entry() */
+static unsigned int IndexLineGen = 1;
+
+/**
+ * mutt_index_line_invalidate - Forget cached index lines
+ * @param h Header whose line has changed, NULL for all of them
+ *
+ * The formatted $index_format line of each message is kept between redraws.
+ * Anything that changes how a message looks must call this.
+ */
+void mutt_index_line_invalidate(struct Header *h)
+{
+  if (h)
+    h->index_gen = 0;
+  else if (++IndexLineGen == 0)
+    IndexLineGen = 1;
+}
+
+/**
+ * is_motion_op - Does this function only move around the index?
+ * @param op Function, e.g. OP_NEXT_PAGE
+ * @retval true If the function doesn't change any message or setting
+ *
+ * The cached index lines survive these; anything else clears them.
+ */
+static bool is_motion_op(int op)
+{
+  switch (op)
+  {
+    case OP_BOTTOM_PAGE:
+    case OP_CURRENT_BOTTOM:
+    case OP_CURRENT_MIDDLE:
+    case OP_CURRENT_TOP:
+    case OP_FIRST_ENTRY:
+    case OP_HALF_DOWN:
+    case OP_HALF_UP:
+    case OP_JUMP:
+    case OP_LAST_ENTRY:
+    case OP_MAIN_NEXT_NEW:
+    case OP_MAIN_NEXT_NEW_THEN_UNREAD:
+    case OP_MAIN_NEXT_UNDELETED:
+    case OP_MAIN_NEXT_UNREAD:
+    case OP_MAIN_PREV_NEW:
+    case OP_MAIN_PREV_NEW_THEN_UNREAD:
+    case OP_MAIN_PREV_UNDELETED:
+    case OP_MAIN_PREV_UNREAD:
+    case OP_MIDDLE_PAGE:
+    case OP_NEXT_ENTRY:
+    case OP_NEXT_LINE:
+    case OP_NEXT_PAGE:
+    case OP_PREV_ENTRY:
+    case OP_PREV_LINE:
+    case OP_PREV_PAGE:
+    case OP_SEARCH:
+    case OP_SEARCH_NEXT:
+    case OP_SEARCH_OPPOSITE:
+    case OP_SEARCH_REVERSE:
+    case OP_TOP_PAGE:
+      return true;
+    default:
+      return false;
+  }
+}
+
 /**
  * collapse/uncollapse all threads
  * @param menu   current menu
@@ -327,6 +394,34 @@ static void resort_index(struct Menu *menu)
   menu->redraw |= REDRAW_INDEX | REDRAW_STATUS;
 }
 
+/**
+ * update_limit - Apply flag changes to the limited view
+ * @param menu Current Menu
+ *
+ * Keep the cursor on the same message, if it's still visible.
+ */
+static void update_limit(struct Menu *menu)
+{
+  struct Header *current = NULL;
+
+  if ((menu->current >= 0) && (menu->current < Context->vcount))
+    current = CURHDR;
+
+  if (!mutt_limit_update(Context))
+    return;
+
+  /* a threaded view will be rebuilt by resort_index() */
+  if (option(OPT_NEED_RESORT))
+    return;
+
+  if (current && (current->virtual >= 0))
+    menu->current = current->virtual;
+  else if (menu->current >= Context->vcount)
+    menu->current = Context->vcount ? Context->vcount - 1 : 0;
+
+  menu->redraw |= REDRAW_INDEX | REDRAW_STATUS;
+}
+
 void update_index(struct Menu *menu, struct Context *ctx, int check, int oldcount, int index_hint)
 {
   /* store pointers to the newly added messages */
@@ -377,7 +472,10 @@ void update_index(struct Menu *menu, struct Context *ctx, int check, int oldcoun
       save_new[i - oldcount] = ctx->hdrs[i];
   }
 
-  /* if the mailbox was reopened, need to rethread from scratch */
+  /* if the mailbox was reopened, need to rethread from scratch, otherwise only
+   * the new messages need threading */
+  if (oldcount && (check != MUTT_REOPENED))
+    set_option(OPT_SORT_NEW_MAIL);
   mutt_sort_headers(ctx, (check == MUTT_REOPENED));
 
   /* uncollapse threads with new mail */
@@ -401,12 +499,9 @@ void update_index(struct Menu *menu, struct Context *ctx, int check, int oldcoun
     {
       for (int i = 0; i < ctx->msgcount - oldcount; i++)
       {
-        for (int k = 0; k < ctx->msgcount; k++)
-        {
-          struct Header *h = ctx->hdrs[k];
-          if (h == save_new[i] && (!ctx->pattern || h->limited))
-            mutt_uncollapse_thread(ctx, h);
-        }
+        struct Header *h = save_new[i];
+        if (!ctx->pattern || h->limited)
+          mutt_uncollapse_thread(ctx, h);
       }
       FREE(&save_new);
       mutt_set_virtual(ctx);
@@ -655,7 +750,71 @@ void index_make_entry(char *s, size_t l, struct Menu *menu, int num)
     }
   }
 
+  if (h->index_line && (h->index_gen == IndexLineGen) &&
+      (h->index_flags == flag) && (h->index_cols == MuttIndexWindow->cols))
+  {
+    mutt_str_strfcpy(s, h->index_line, l);
+    return;
+  }
+
   mutt_make_string_flags(s, l, NONULL(IndexFormat), Context, h, flag);
+
+  mutt_str_replace(&h->index_line, s);
+  h->index_gen = IndexLineGen;
+  h->index_flags = flag;
+  h->index_cols = MuttIndexWindow->cols;
+}
+
+/**
+ * index_line_cached - Is a message's index line up to date?
+ * @param num Index of the message in the view
+ * @retval true If the cached line can be used
+ */
+static bool index_line_cached(int num)
+{
+  struct Header *h = Context->hdrs[Context->v2r[num]];
+
+  return h && h->index_line && (h->index_gen == IndexLineGen) &&
+         (h->index_cols == MuttIndexWindow->cols);
+}
+
+/**
+ * index_prerender - Format the pages around the visible one
+ * @param menu Index menu
+ *
+ * This is run after the screen has been refreshed, before waiting for a key.
+ * It fills the index line cache for the previous and next pages, so that
+ * paging and scrolling only have to copy them to the screen.
+ *
+ * Only the lines that aren't cached are formatted, and nothing is done while
+ * there's typeahead, so that it never delays a key press.
+ */
+static void index_prerender(struct Menu *menu)
+{
+  char buf[LONG_STRING];
+
+  if (!Context || (menu->pagelen <= 0) || (menu->max <= menu->pagelen))
+    return;
+
+  int top = menu->top;
+  int tops[2] = { top + menu->pagelen, top - menu->pagelen };
+
+  for (int i = 0; i < 2; i++)
+  {
+    if ((tops[i] < 0) || (tops[i] >= menu->max))
+      continue;
+
+    if (mutt_input_pending())
+      break;
+
+    /* the thread flags depend on what's at the top of the screen */
+    menu->top = tops[i];
+    for (int j = tops[i]; (j < tops[i] + menu->pagelen) && (j < menu->max); j++)
+      if (!index_line_cached(j))
+        index_make_entry(buf, sizeof(buf), menu, j);
+  }
+
+  menu->top = top;
 }
 
 int index_color(int index_no)
@@ -947,6 +1106,9 @@ int mutt_index_menu(void)
      * any 'op' below could do mutt_enter_command(), either here or
      * from any new menu launched, and change $sort/$sort_aux
      */
+    if (Context && Context->limit_dirty)
+      update_limit(menu);
+
     if (option(OPT_NEED_RESORT) && Context && Context->msgcount && menu->current >= 0)
       resort_index(menu);
 
@@ -956,6 +1118,7 @@ int mutt_index_menu(void)
     if (option(OPT_REDRAW_TREE) && Context && Context->msgcount && (Sort & SORT_MASK) == SORT_THREADS)
     {
       mutt_draw_tree(Context);
+      mutt_index_line_invalidate(NULL);
       menu->redraw |= REDRAW_STATUS;
       unset_option(OPT_REDRAW_TREE);
     }
@@ -976,6 +1139,9 @@ int mutt_index_menu(void)
               CURHDR->index :
               0;
 
+#ifdef USE_INOTIFY
+      MonitorContextChanged = false;
+#endif
       check = mx_check_mailbox(Context, &index_hint);
       if (check < 0)
       {
@@ -1020,6 +1186,8 @@ int mutt_index_menu(void)
         /* avoid the message being overwritten by buffy */
         do_buffy_notify = false;
 
+        mutt_index_line_invalidate(NULL);
+
         bool q = Context->quiet;
         Context->quiet = true;
         update_index(menu, Context, check, oldcount, index_hint);
@@ -1030,6 +1198,11 @@ int mutt_index_menu(void)
 
         set_option(OPT_SEARCH_INVALID);
       }
+#ifdef USE_INOTIFY
+      /* wake up when the mailbox changes */
+      if (Context)
+        mutt_monitor_add(NULL);
+#endif
     }
 
     if (!attach_msg)
@@ -1103,6 +1276,8 @@ int mutt_index_menu(void)
       }
 #endif
 
+      index_prerender(menu);
+
       op = km_dokey(MENU_MAIN);
 
       mutt_debug(4, "mutt_index_menu[%d]: Got op %d\n", __LINE__, op);
@@ -1110,7 +1285,11 @@ int mutt_index_menu(void)
       /* either user abort or timeout */
       if (op < 0)
       {
-        mutt_timeout_hook();
+#ifdef USE_INOTIFY
+        /* woken up by a mailbox changing, not a real timeout */
+        if (!MonitorFilesChanged && !MonitorContextChanged)
+#endif
+          mutt_timeout_hook();
         if (tag)
           mutt_window_clearline(MuttMessageWindow, 0);
         continue;
@@ -1118,6 +1297,9 @@ int mutt_index_menu(void)
 
       mutt_curs_set(1);
 
+      if (!is_motion_op(op))
+        mutt_index_line_invalidate(NULL);
+
       /* special handling for the tag-prefix function */
       if (op == OP_TAG_PREFIX || op == OP_TAG_PREFIX_COND)
       {
@@ -2172,6 +2354,7 @@ int mutt_index_menu(void)
         menu->menu = MENU_MAIN;
 
         op = mutt_display_message(CURHDR);
+        mutt_index_line_invalidate(NULL);
         if (op < 0)
         {
           unset_option(OPT_NEED_RESORT);
@@ -115,7 +115,7 @@ syn keyword muttrcVarBool	skipwhite contained
 			\ hide_thread_subject hide_top_limited hide_top_missing honor_disposition
 			\ idn_decode idn_encode ignore_linear_white_space ignore_list_reply_to
 			\ imap_check_subscribed imap_list_subscribed imap_passive imap_peek
-			\ imap_servernoise implicit_autoview include_onlyfirst keep_flagged
+			\ imap_servernoise implicit_autoview include_onlyfirst keep_flagged limit_refresh
 			\ mail_check_recent mail_check_stats mailcap_sanitize maildir_check_cur
 			\ maildir_header_cache_verify maildir_trash mark_old markers menu_move_off
 			\ menu_scroll message_cache_clean meta_key metoo mh_purge mime_forward_decode
@@ -152,7 +152,7 @@ syn keyword muttrcVarBool	skipwhite contained
 			\ nohide_thread_subject nohide_top_limited nohide_top_missing nohonor_disposition
 			\ noidn_decode noidn_encode noignore_linear_white_space noignore_list_reply_to
 			\ noimap_check_subscribed noimap_list_subscribed noimap_passive noimap_peek
-			\ noimap_servernoise noimplicit_autoview noinclude_onlyfirst nokeep_flagged
+			\ noimap_servernoise noimplicit_autoview noinclude_onlyfirst nokeep_flagged nolimit_refresh
 			\ nomail_check_recent nomail_check_stats nomailcap_sanitize nomaildir_check_cur
 			\ nomaildir_header_cache_verify nomaildir_trash nomark_old nomarkers nomenu_move_off
 			\ nomenu_scroll nomessage_cache_clean nometa_key nometoo nomh_purge nomime_forward_decode
@@ -189,7 +189,7 @@ syn keyword muttrcVarBool	skipwhite contained
 			\ invhide_thread_subject invhide_top_limited invhide_top_missing invhonor_disposition
 			\ invidn_decode invidn_encode invignore_linear_white_space invignore_list_reply_to
 			\ invimap_check_subscribed invimap_list_subscribed invimap_passive invimap_peek
-			\ invimap_servernoise invimplicit_autoview invinclude_onlyfirst invkeep_flagged
+			\ invimap_servernoise invimplicit_autoview invinclude_onlyfirst invkeep_flagged invlimit_refresh
 			\ invmail_check_recent invmail_check_stats invmailcap_sanitize invmaildir_check_cur
 			\ invmaildir_header_cache_verify invmaildir_trash invmark_old invmarkers invmenu_move_off
 			\ invmenu_scroll invmessage_cache_clean invmeta_key invmetoo invmh_purge invmime_forward_decode
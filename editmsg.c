@@ -90,7 +90,10 @@ static int edit_or_view_one_message(bool edit, struct Context *ctx, struct Heade
 
   rc = mutt_append_message(
       &tmpctx, ctx, cur, 0,
-      CH_NOLEN | ((ctx->magic == MUTT_MBOX || ctx->magic == MUTT_MMDF) ? 0 : CH_NOSTATUS));
+      CH_NOLEN | ((ctx->magic == MUTT_MBOX || ctx->magic == MUTT_MMDF ||
+                   ctx->magic == MUTT_ZMBOX) ?
+                      0 :
+                      CH_NOSTATUS));
   oerrno = errno;
 
   mx_close_mailbox(&tmpctx, NULL);
@@ -35,9 +35,12 @@
 #include "config.h"
 #include <stddef.h>
 #include "mutt/buffer.h"
+#include "mutt/intern.h"
 #include "mutt/memory.h"
+#include "mutt/pool.h"
 #include "mutt/queue.h"
 #include "envelope.h"
+#include "address.h"
 #include "rfc822.h"
 
 /**
@@ -46,7 +49,24 @@
  */
 struct Envelope *mutt_new_envelope(void)
 {
-  struct Envelope *e = mutt_mem_calloc(1, sizeof(struct Envelope));
+  return mutt_new_pooled_envelope(NULL);
+}
+
+/**
+ * mutt_new_pooled_envelope - Create a new Envelope in a mailbox's storage
+ * @param pool Storage to use, NULL to malloc the Envelope
+ * @retval ptr New Envelope
+ */
+struct Envelope *mutt_new_pooled_envelope(struct Pool *pool)
+{
+  struct Envelope *e = NULL;
+  if (pool)
+  {
+    e = mutt_pool_alloc(pool);
+    e->pool = pool;
+  }
+  else
+    e = mutt_mem_calloc(1, sizeof(struct Envelope));
   STAILQ_INIT(&e->references);
   STAILQ_INIT(&e->in_reply_to);
   STAILQ_INIT(&e->userhdrs);
@@ -70,8 +90,8 @@ void mutt_free_envelope(struct Envelope **p)
   rfc822_free_address(&(*p)->reply_to);
   rfc822_free_address(&(*p)->mail_followup_to);
 
-  FREE(&(*p)->list_post);
-  FREE(&(*p)->subject);
+  mutt_intern_release(&(*p)->list_post);
+  mutt_intern_release(&(*p)->subject);
   /* real_subj is just an offset to subject and shouldn't be freed */
   FREE(&(*p)->disp_subj);
   FREE(&(*p)->message_id);
@@ -91,7 +111,60 @@ void mutt_free_envelope(struct Envelope **p)
   mutt_list_free(&(*p)->references);
   mutt_list_free(&(*p)->in_reply_to);
   mutt_list_free(&(*p)->userhdrs);
-  FREE(p);
+  if ((*p)->pool)
+  {
+    mutt_pool_free((*p)->pool, *p);
+    *p = NULL;
+  }
+  else
+    FREE(p);
+}
+
+/**
+ * intern_adrlist - Share the strings of a list of Addresses
+ * @param a Address list
+ */
+static void intern_adrlist(struct Address *a)
+{
+  for (; a; a = a->next)
+  {
+    mutt_intern_take(&a->personal);
+    mutt_intern_take(&a->mailbox);
+  }
+}
+
+/**
+ * mutt_intern_envelope - Share the strings that repeat between emails
+ * @param env Envelope
+ *
+ * The names and addresses, the subject and the List-Post header are replaced
+ * by shared copies, see mutt_intern_add().  They must be treated as read-only
+ * from now on.
+ */
+void mutt_intern_envelope(struct Envelope *env)
+{
+  if (!env)
+    return;
+
+  intern_adrlist(env->return_path);
+  intern_adrlist(env->from);
+  intern_adrlist(env->to);
+  intern_adrlist(env->cc);
+  intern_adrlist(env->bcc);
+  intern_adrlist(env->sender);
+  intern_adrlist(env->reply_to);
+  intern_adrlist(env->mail_followup_to);
+
+  mutt_intern_take(&env->list_post);
+
+  if (env->subject)
+  {
+    /* real_subj points into the subject */
+    size_t off = env->real_subj ? env->real_subj - env->subject : 0;
+    mutt_intern_take(&env->subject);
+    if (env->real_subj)
+      env->real_subj = env->subject + off;
+  }
 }
 
 /**
@@ -62,10 +62,14 @@ struct Envelope
 
   bool irt_changed : 1;  /**< In-Reply-To changed to link/break threads */
   bool refs_changed : 1; /**< References changed to break thread */
+
+  struct Pool *pool; /**< storage this Envelope came from, NULL if malloc'd */
 };
 
 struct Envelope *mutt_new_envelope(void);
+struct Envelope *mutt_new_pooled_envelope(struct Pool *pool);
 void mutt_free_envelope(struct Envelope **p);
 void mutt_merge_envelopes(struct Envelope *base, struct Envelope **extra);
+void mutt_intern_envelope(struct Envelope *env);
 
 #endif /* _MUTT_ENVELOPE_H */
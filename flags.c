@@ -315,6 +315,12 @@ void mutt_set_flag_update(struct Context *ctx, struct Header *h, int flag, int b
   if (update)
   {
     mutt_set_header_color(ctx, h);
+    mutt_index_line_invalidate(h);
+    if (ctx->pattern && option(OPT_LIMIT_REFRESH))
+    {
+      h->limit_dirty = true;
+      ctx->limit_dirty = true;
+    }
 #ifdef USE_SIDEBAR
     mutt_set_current_menu_redraw(REDRAW_SIDEBAR);
 #endif
@@ -89,6 +89,7 @@ WHERE char *MailcapPath;
 WHERE char *Folder;
 #if defined(USE_IMAP) || defined(USE_POP) || defined(USE_NNTP)
 WHERE char *MessageCachedir;
+WHERE short MessageCacheSize;
 #endif
 #ifdef USE_HCACHE
 WHERE char *HeaderCache;
@@ -0,0 +1,666 @@
+/**
+ * @file
+ * Random access to gzip-compressed files
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * A gzip file can only be decompressed from the start.  To be able to seek,
+ * the state of the decompressor is saved every #GZ_SPAN bytes of output: the
+ * position in the compressed file and the last 32K of output, which is all
+ * that deflate needs to carry on.  A seek then only has to decompress from the
+ * nearest saved point.  This is the technique of zlib's examples/zran.c.
+ *
+ * The index is built by reading the whole file once, when it's opened.  That
+ * also gives the size of the decompressed data, which the mbox parser needs.
+ * The index is saved in the header cache, so next time the file can be read
+ * straight away.
+ *
+ * The decompressed data is presented as a read-only, seekable FILE, using
+ * fopencookie(3), so the mbox code can read it like any other mailbox.
+ */
+
+#include "config.h"
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#include "mutt/mutt.h"
+#include "gzstream.h"
+#include "globals.h"
+#include "mutt_curses.h"
+#ifdef USE_HCACHE
+#include "hcache/hcache.h"
+#endif
+
+#define GZ_WINSIZE 32768         /**< deflate's history window */
+#define GZ_SPAN (1024 * 1024)    /**< output between access points */
+#define GZ_CHUNK 16384           /**< compressed data read at a time */
+#define GZ_INDEX_VERSION 1       /**< version of the index in the header cache */
+
+/**
+ * struct GzPoint - A place the decompression can be restarted from
+ */
+struct GzPoint
+{
+  LOFF_T out;            /**< offset in the decompressed data */
+  LOFF_T in;             /**< offset of the next whole byte in the compressed file */
+  int bits;              /**< unused bits in the byte before 'in', 0-7 */
+  unsigned char *window; /**< the GZ_WINSIZE bytes of output before 'out' */
+};
+
+/**
+ * struct GzStream - A gzip file being read
+ */
+struct GzStream
+{
+  FILE *fp;                 /**< compressed file */
+  z_stream strm;            /**< decompressor */
+  bool raw;                 /**< strm was restarted from a GzPoint */
+  bool eof;                 /**< all the data has been decompressed */
+  LOFF_T pos;               /**< offset of the next byte of output */
+  LOFF_T size;              /**< size of the decompressed data, -1 if not known */
+  unsigned char in[GZ_CHUNK];
+  unsigned char window[GZ_WINSIZE]; /**< circular buffer of recent output */
+  unsigned int wpos;        /**< where the next output goes in window */
+  struct GzPoint *points;   /**< access points, in order */
+  size_t num_points;        /**< number of access points */
+  size_t max_points;        /**< size of the points array */
+};
+
+/**
+ * mutt_gz_is_gzip - Is this a gzip file?
+ * @param path File to check
+ * @retval true The file starts with the gzip magic number
+ */
+bool mutt_gz_is_gzip(const char *path)
+{
+  unsigned char magic[2];
+  bool rc = false;
+
+  FILE *fp = fopen(path, "r");
+  if (!fp)
+    return false;
+
+  if ((fread(magic, 1, sizeof(magic), fp) == sizeof(magic)) && (magic[0] == 0x1f) &&
+      (magic[1] == 0x8b))
+  {
+    rc = true;
+  }
+
+  fclose(fp);
+  return rc;
+}
+
+/**
+ * gz_restart - Start decompressing from the beginning of the file
+ * @param gs Stream
+ * @retval  0 Success
+ * @retval -1 Error
+ */
+static int gz_restart(struct GzStream *gs)
+{
+  if (fseeko(gs->fp, 0, SEEK_SET) != 0)
+    return -1;
+
+  gs->strm.avail_in = 0;
+  gs->strm.next_in = gs->in;
+  if (inflateReset2(&gs->strm, 31) != Z_OK)
+    return -1;
+
+  gs->raw = false;
+  gs->eof = false;
+  gs->pos = 0;
+  gs->wpos = 0;
+  memset(gs->window, 0, sizeof(gs->window));
+  return 0;
+}
+
+/**
+ * gz_resume - Start decompressing from an access point
+ * @param gs Stream
+ * @param pt Access point
+ * @retval  0 Success
+ * @retval -1 Error
+ */
+static int gz_resume(struct GzStream *gs, const struct GzPoint *pt)
+{
+  if (fseeko(gs->fp, pt->in - (pt->bits ? 1 : 0), SEEK_SET) != 0)
+    return -1;
+
+  gs->strm.avail_in = 0;
+  gs->strm.next_in = gs->in;
+  if (inflateReset2(&gs->strm, -15) != Z_OK)
+    return -1;
+
+  if (pt->bits)
+  {
+    int c = fgetc(gs->fp);
+    if (c == EOF)
+      return -1;
+    inflatePrime(&gs->strm, pt->bits, c >> (8 - pt->bits));
+  }
+
+  if (inflateSetDictionary(&gs->strm, pt->window, GZ_WINSIZE) != Z_OK)
+    return -1;
+
+  gs->raw = true;
+  gs->eof = false;
+  gs->pos = pt->out;
+  memcpy(gs->window, pt->window, GZ_WINSIZE);
+  gs->wpos = 0;
+  return 0;
+}
+
+/**
+ * gz_add_point - Remember the decompressor's state
+ * @param gs Stream
+ */
+static void gz_add_point(struct GzStream *gs)
+{
+  if (gs->num_points == gs->max_points)
+  {
+    gs->max_points = gs->max_points ? gs->max_points * 2 : 64;
+    mutt_mem_realloc(&gs->points, gs->max_points * sizeof(struct GzPoint));
+  }
+
+  struct GzPoint *pt = &gs->points[gs->num_points++];
+  pt->out = gs->pos;
+  pt->in = ftello(gs->fp) - gs->strm.avail_in;
+  pt->bits = gs->strm.data_type & 7;
+  pt->window = mutt_mem_malloc(GZ_WINSIZE);
+
+  /* the window is circular, the oldest byte is at wpos */
+  memcpy(pt->window, gs->window + gs->wpos, GZ_WINSIZE - gs->wpos);
+  memcpy(pt->window + GZ_WINSIZE - gs->wpos, gs->window, gs->wpos);
+}
+
+/**
+ * gz_next_member - Get ready for another gzip member, if there is one
+ * @param gs Stream
+ * @retval  0 There's another member
+ * @retval  1 End of the file
+ * @retval -1 Error
+ *
+ * gzip files may be concatenated.  A stream resumed from an access point is
+ * raw deflate, so the member's trailer still has to be skipped.
+ */
+static int gz_next_member(struct GzStream *gs)
+{
+  if (gs->raw)
+  {
+    /* skip the CRC and size */
+    for (int i = 0; i < 8; i++)
+    {
+      if (gs->strm.avail_in == 0)
+      {
+        gs->strm.avail_in = fread(gs->in, 1, sizeof(gs->in), gs->fp);
+        gs->strm.next_in = gs->in;
+        if (gs->strm.avail_in == 0)
+          return -1;
+      }
+      gs->strm.avail_in--;
+      gs->strm.next_in++;
+    }
+  }
+
+  if (gs->strm.avail_in == 0)
+  {
+    gs->strm.avail_in = fread(gs->in, 1, sizeof(gs->in), gs->fp);
+    gs->strm.next_in = gs->in;
+  }
+
+  /* anything else, e.g. padding, is ignored, as gzip(1) does */
+  if ((gs->strm.avail_in == 0) || (gs->strm.next_in[0] != 0x1f))
+    return 1;
+
+  if (inflateReset2(&gs->strm, 31) != Z_OK)
+    return -1;
+  gs->raw = false;
+  return 0;
+}
+
+/**
+ * gz_inflate - Decompress some data
+ * @param gs  Stream
+ * @param buf Buffer for the data, NULL to discard it
+ * @param len Number of bytes wanted
+ * @retval >=0 Number of bytes decompressed, less than len at the end
+ * @retval  -1 Error
+ *
+ * Access points are added as new parts of the file are reached.
+ */
+static ssize_t gz_inflate(struct GzStream *gs, char *buf, size_t len)
+{
+  size_t done = 0;
+
+  while ((done < len) && !gs->eof)
+  {
+    if (gs->strm.avail_in == 0)
+    {
+      gs->strm.avail_in = fread(gs->in, 1, sizeof(gs->in), gs->fp);
+      gs->strm.next_in = gs->in;
+      if (gs->strm.avail_in == 0)
+      {
+        mutt_debug(1, "gzip file is truncated\n");
+        return -1;
+      }
+    }
+
+    size_t want = MIN(GZ_WINSIZE - gs->wpos, len - done);
+    gs->strm.next_out = gs->window + gs->wpos;
+    gs->strm.avail_out = want;
+
+    int ret = inflate(&gs->strm, Z_BLOCK);
+    if ((ret == Z_NEED_DICT) || (ret == Z_DATA_ERROR) || (ret == Z_MEM_ERROR) ||
+        (ret == Z_STREAM_ERROR))
+    {
+      mutt_debug(1, "inflate failed: %d %s\n", ret, NONULL(gs->strm.msg));
+      return -1;
+    }
+
+    size_t n = want - gs->strm.avail_out;
+    if (buf)
+      memcpy(buf + done, gs->window + gs->wpos, n);
+    done += n;
+    gs->pos += n;
+    gs->wpos = (gs->wpos + n) % GZ_WINSIZE;
+
+    if (ret == Z_STREAM_END)
+    {
+      int rc = gz_next_member(gs);
+      if (rc < 0)
+        return -1;
+      if (rc > 0)
+      {
+        gs->eof = true;
+        gs->size = gs->pos;
+      }
+      continue;
+    }
+
+    /* at the end of a deflate block, other than the last, we can save the state */
+    if ((gs->strm.data_type & 128) && !(gs->strm.data_type & 64))
+    {
+      LOFF_T last = gs->num_points ? gs->points[gs->num_points - 1].out : -GZ_SPAN;
+      if (gs->pos - last >= GZ_SPAN)
+        gz_add_point(gs);
+    }
+  }
+
+  return done;
+}
+
+/**
+ * gz_seek - Move to a place in the decompressed data
+ * @param gs     Stream
+ * @param target Offset to move to
+ * @retval  0 Success
+ * @retval -1 Error
+ */
+static int gz_seek(struct GzStream *gs, LOFF_T target)
+{
+  char scratch[GZ_CHUNK];
+
+  if (target == gs->pos)
+    return 0;
+
+  /* find the last access point before the target */
+  struct GzPoint *pt = NULL;
+  size_t lo = 0, hi = gs->num_points;
+  while (lo < hi)
+  {
+    size_t mid = (lo + hi) / 2;
+    if (gs->points[mid].out <= target)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (lo > 0)
+    pt = &gs->points[lo - 1];
+
+  /* carry on from here, if that's no further than from the access point */
+  if ((target < gs->pos) || (pt && (pt->out > gs->pos)))
+  {
+    int rc = pt ? gz_resume(gs, pt) : gz_restart(gs);
+    if (rc != 0)
+      return -1;
+  }
+
+  while (gs->pos < target)
+  {
+    ssize_t n = gz_inflate(gs, NULL, MIN(sizeof(scratch), (size_t)(target - gs->pos)));
+    if (n < 0)
+      return -1;
+    if (n == 0)
+      break;
+  }
+
+  return 0;
+}
+
+/**
+ * gz_cookie_read - Read from a gzip stream, fopencookie(3) callback
+ */
+static ssize_t gz_cookie_read(void *cookie, char *buf, size_t size)
+{
+  return gz_inflate(cookie, buf, size);
+}
+
+/**
+ * gz_cookie_seek - Seek in a gzip stream, fopencookie(3) callback
+ */
+static int gz_cookie_seek(void *cookie, off64_t *offset, int whence)
+{
+  struct GzStream *gs = cookie;
+  LOFF_T target;
+
+  switch (whence)
+  {
+    case SEEK_SET:
+      target = *offset;
+      break;
+    case SEEK_CUR:
+      target = gs->pos + *offset;
+      break;
+    case SEEK_END:
+      target = gs->size + *offset;
+      break;
+    default:
+      errno = EINVAL;
+      return -1;
+  }
+
+  if (target < 0)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (gz_seek(gs, target) != 0)
+  {
+    errno = EIO;
+    return -1;
+  }
+
+  *offset = gs->pos;
+  return 0;
+}
+
+/**
+ * gz_free - Free a gzip stream
+ * @param gs Stream to free
+ */
+static void gz_free(struct GzStream **gs)
+{
+  if (!gs || !*gs)
+    return;
+
+  inflateEnd(&(*gs)->strm);
+  mutt_file_fclose(&(*gs)->fp);
+  for (size_t i = 0; i < (*gs)->num_points; i++)
+    FREE(&(*gs)->points[i].window);
+  FREE(&(*gs)->points);
+  FREE(gs);
+}
+
+/**
+ * gz_cookie_close - Close a gzip stream, fopencookie(3) callback
+ */
+static int gz_cookie_close(void *cookie)
+{
+  struct GzStream *gs = cookie;
+  gz_free(&gs);
+  return 0;
+}
+
+#ifdef USE_HCACHE
+/**
+ * struct GzIndexHeader - Start of a saved index
+ */
+struct GzIndexHeader
+{
+  uint32_t version;   /**< GZ_INDEX_VERSION */
+  uint32_t points;    /**< number of access points */
+  LOFF_T csize;       /**< size of the compressed file */
+  LOFF_T size;        /**< size of the decompressed data */
+  time_t mtime;       /**< modification time of the compressed file */
+};
+
+/**
+ * struct GzIndexPoint - A saved access point, followed by its window
+ */
+struct GzIndexPoint
+{
+  LOFF_T out;      /**< offset in the decompressed data */
+  LOFF_T in;       /**< offset in the compressed file */
+  uint32_t bits;   /**< unused bits in the byte before 'in' */
+  uint32_t wlen;   /**< length of the compressed window that follows */
+};
+
+/**
+ * gz_index_fetch - Load a gzip file's index from the header cache
+ * @param gs Stream
+ * @param path Path of the gzip file
+ * @param sb   File's details, to check the index is up to date
+ * @retval true The index was loaded
+ */
+static bool gz_index_fetch(struct GzStream *gs, const char *path, const struct stat *sb)
+{
+  header_cache_t *hc = mutt_hcache_open(HeaderCache, path, NULL);
+  if (!hc)
+    return false;
+
+  bool rc = false;
+  unsigned char *data = mutt_hcache_fetch_raw(hc, "/GZINDEX", 8);
+  if (!data)
+    goto done;
+
+  struct GzIndexHeader hdr;
+  memcpy(&hdr, data, sizeof(hdr));
+  if ((hdr.version != GZ_INDEX_VERSION) || (hdr.csize != sb->st_size) ||
+      (hdr.mtime != sb->st_mtime))
+  {
+    goto done;
+  }
+
+  unsigned char *p = data + sizeof(hdr);
+  for (uint32_t i = 0; i < hdr.points; i++)
+  {
+    struct GzIndexPoint ip;
+    memcpy(&ip, p, sizeof(ip));
+    p += sizeof(ip);
+
+    if (gs->num_points == gs->max_points)
+    {
+      gs->max_points = gs->max_points ? gs->max_points * 2 : 64;
+      mutt_mem_realloc(&gs->points, gs->max_points * sizeof(struct GzPoint));
+    }
+    struct GzPoint *pt = &gs->points[gs->num_points];
+    pt->out = ip.out;
+    pt->in = ip.in;
+    pt->bits = ip.bits;
+    pt->window = mutt_mem_malloc(GZ_WINSIZE);
+
+    uLongf wlen = GZ_WINSIZE;
+    if ((uncompress(pt->window, &wlen, p, ip.wlen) != Z_OK) || (wlen != GZ_WINSIZE))
+    {
+      FREE(&pt->window);
+      goto done;
+    }
+    p += ip.wlen;
+    gs->num_points++;
+  }
+
+  gs->size = hdr.size;
+  rc = true;
+
+done:
+  if (!rc)
+  {
+    for (size_t i = 0; i < gs->num_points; i++)
+      FREE(&gs->points[i].window);
+    gs->num_points = 0;
+  }
+  mutt_hcache_free(hc, (void **) &data);
+  mutt_hcache_close(hc);
+  return rc;
+}
+
+/**
+ * gz_index_store - Save a gzip file's index in the header cache
+ * @param gs   Stream
+ * @param path Path of the gzip file
+ * @param sb   File's details, to check the index is up to date
+ */
+static void gz_index_store(struct GzStream *gs, const char *path, const struct stat *sb)
+{
+  header_cache_t *hc = mutt_hcache_open(HeaderCache, path, NULL);
+  if (!hc)
+    return;
+
+  uLong bound = compressBound(GZ_WINSIZE);
+  size_t len = sizeof(struct GzIndexHeader) +
+               gs->num_points * (sizeof(struct GzIndexPoint) + bound);
+  unsigned char *data = mutt_mem_malloc(len);
+
+  struct GzIndexHeader hdr = { 0 };
+  hdr.version = GZ_INDEX_VERSION;
+  hdr.points = gs->num_points;
+  hdr.csize = sb->st_size;
+  hdr.size = gs->size;
+  hdr.mtime = sb->st_mtime;
+  memcpy(data, &hdr, sizeof(hdr));
+
+  unsigned char *p = data + sizeof(hdr);
+  for (size_t i = 0; i < gs->num_points; i++)
+  {
+    struct GzIndexPoint ip = { 0 };
+    uLongf wlen = bound;
+    if (compress(p + sizeof(ip), &wlen, gs->points[i].window, GZ_WINSIZE) != Z_OK)
+      goto done;
+
+    ip.out = gs->points[i].out;
+    ip.in = gs->points[i].in;
+    ip.bits = gs->points[i].bits;
+    ip.wlen = wlen;
+    memcpy(p, &ip, sizeof(ip));
+    p += sizeof(ip) + wlen;
+  }
+
+  mutt_hcache_store_raw(hc, "/GZINDEX", 8, data, p - data);
+
+done:
+  FREE(&data);
+  mutt_hcache_close(hc);
+}
+#endif
+
+/**
+ * gz_build_index - Read a whole gzip file, to index it
+ * @param gs   Stream
+ * @param path Path of the gzip file, for messages
+ * @param csize Size of the gzip file
+ * @retval  0 Success
+ * @retval -1 Error
+ * @retval -2 Aborted by the user
+ */
+static int gz_build_index(struct GzStream *gs, const char *path, LOFF_T csize)
+{
+  char msg[STRING];
+  struct Progress progress;
+  char scratch[GZ_CHUNK];
+  ssize_t n;
+
+  snprintf(msg, sizeof(msg), _("Indexing %s..."), path);
+  mutt_progress_init(&progress, msg, MUTT_PROGRESS_SIZE, NetInc, csize);
+
+  while ((n = gz_inflate(gs, scratch, sizeof(scratch))) > 0)
+  {
+    if (SigInt == 1)
+    {
+      SigInt = 0;
+      return -2;
+    }
+    mutt_progress_update(&progress, ftello(gs->fp), -1);
+  }
+
+  if (n < 0)
+    return -1;
+
+  return gz_restart(gs);
+}
+
+/**
+ * mutt_gz_open - Open a gzip file for random access
+ * @param[in]  path Path of the gzip file
+ * @param[out] size Size of the decompressed data
+ * @retval ptr  Read-only, seekable stream of the decompressed data
+ * @retval NULL Error
+ */
+FILE *mutt_gz_open(const char *path, LOFF_T *size)
+{
+  struct stat sb;
+  struct GzStream *gs = mutt_mem_calloc(1, sizeof(struct GzStream));
+
+  gs->size = -1;
+  gs->fp = fopen(path, "r");
+  if (!gs->fp || (fstat(fileno(gs->fp), &sb) != 0))
+  {
+    mutt_perror(path);
+    goto fail;
+  }
+
+  if (inflateInit2(&gs->strm, 31) != Z_OK)
+    goto fail;
+
+#ifdef USE_HCACHE
+  if (!gz_index_fetch(gs, path, &sb))
+#endif
+  {
+    int rc = gz_build_index(gs, path, sb.st_size);
+    if (rc != 0)
+    {
+      if (rc == -1)
+        mutt_error(_("Error decompressing %s"), path);
+      goto fail;
+    }
+#ifdef USE_HCACHE
+    gz_index_store(gs, path, &sb);
+#endif
+  }
+
+  cookie_io_functions_t io = {
+    .read = gz_cookie_read,
+    .write = NULL,
+    .seek = gz_cookie_seek,
+    .close = gz_cookie_close,
+  };
+
+  FILE *fp = fopencookie(gs, "r", io);
+  if (!fp)
+    goto fail;
+
+  *size = gs->size;
+  return fp;
+
+fail:
+  gz_free(&gs);
+  return NULL;
+}
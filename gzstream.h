@@ -0,0 +1,30 @@
+/**
+ * @file
+ * Random access to gzip-compressed files
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MUTT_GZSTREAM_H
+#define _MUTT_GZSTREAM_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+bool  mutt_gz_is_gzip(const char *path);
+FILE *mutt_gz_open(const char *path, LOFF_T *size);
+
+#endif /* _MUTT_GZSTREAM_H */
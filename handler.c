@@ -1307,6 +1307,9 @@ static int multipart_handler(struct Body *a, struct State *s)
 
   for (p = b->parts, count = 1; p; p = p->next, count++)
   {
+    if (s->flags & MUTT_STOP)
+      break;
+
     if (s->flags & MUTT_DISPLAY)
     {
       state_mark_attach(s);
@@ -1822,6 +1825,10 @@ int mutt_body_handler(struct Body *b, struct State *s)
   if (!b || !s)
     return -1;
 
+  /* the reader of our output already has what it wants */
+  if (s->flags & MUTT_STOP)
+    return 0;
+
   bool plaintext = false;
   handler_t handler = NULL;
   int rc = 0;
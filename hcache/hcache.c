@@ -400,6 +400,7 @@ static unsigned char *dump_body(struct Body *c, unsigned char *d, int *off, bool
   nb.parts = NULL;
   nb.hdr = NULL;
   nb.aptr = NULL;
+  nb.pool = NULL;
 
   lazy_realloc(&d, *off + sizeof(struct Body));
   memcpy(d + *off, &nb, sizeof(struct Body));
@@ -422,6 +423,7 @@ static void restore_body(struct Body *c, const unsigned char *d, int *off, bool
 {
   memcpy(c, d + *off, sizeof(struct Body));
   *off += sizeof(struct Body);
+  c->pool = NULL;
 
   restore_char(&c->xtype, d, off, false);
   restore_char(&c->subtype, d, off, false);
@@ -673,6 +675,8 @@ static void *hcache_dump(header_cache_t *h, struct Header *header, int *off,
   nh.path = NULL;
   nh.tree = NULL;
   nh.thread = NULL;
+  nh.pool = NULL;
+  nh.index_line = NULL;
   STAILQ_INIT(&nh.tags);
 #ifdef MIXMASTER
   STAILQ_INIT(&nh.chain);
@@ -705,9 +709,12 @@ struct Header *mutt_hcache_restore(const unsigned char *d)
 
   memcpy(h, d + off, sizeof(struct Header));
   off += sizeof(struct Header);
+  h->pool = NULL;
+  h->index_line = NULL;
 
   h->env = mutt_new_envelope();
   restore_envelope(h->env, d, &off, convert);
+  mutt_intern_envelope(h->env);
 
   h->content = mutt_new_body();
   restore_body(h->content, d, &off, convert);
@@ -310,6 +310,7 @@ int mutt_label_message(struct Header *hdr)
     {
       changed++;
       mutt_set_header_color(Context, hdr);
+      mutt_index_line_invalidate(hdr);
     }
   }
   else
@@ -365,6 +366,7 @@ void mutt_free_header(struct Header **h)
   FREE(&(*h)->maildir_flags);
   FREE(&(*h)->tree);
   FREE(&(*h)->path);
+  FREE(&(*h)->index_line);
 #ifdef MIXMASTER
   mutt_list_free(&(*h)->chain);
 #endif
@@ -374,15 +376,72 @@ void mutt_free_header(struct Header **h)
     (*h)->free_cb(*h);
   FREE(&(*h)->data);
 #endif
-  FREE(h);
+  if ((*h)->pool)
+  {
+    mutt_pool_free((*h)->pool->headers, *h);
+    *h = NULL;
+  }
+  else
+    FREE(h);
 }
 
 struct Header *mutt_new_header(void)
 {
-  struct Header *h = mutt_mem_calloc(1, sizeof(struct Header));
+  return mutt_new_pooled_header(NULL);
+}
+
+/**
+ * mutt_new_pooled_header - Create a new Header in a mailbox's storage
+ * @param pool Storage to use, may be NULL
+ * @retval ptr New Header
+ *
+ * If pool is NULL, the Header is malloc'd.  Otherwise, the Envelope and Body
+ * read by mutt_read_rfc822_header() will come from the same pool.
+ */
+struct Header *mutt_new_pooled_header(struct HeaderPool *pool)
+{
+  struct Header *h = NULL;
+  if (pool)
+  {
+    h = mutt_pool_alloc(pool->headers);
+    h->pool = pool;
+  }
+  else
+    h = mutt_mem_calloc(1, sizeof(struct Header));
 #ifdef MIXMASTER
   STAILQ_INIT(&h->chain);
 #endif
   STAILQ_INIT(&h->tags);
   return h;
 }
+
+/**
+ * mutt_header_pool_new - Create storage for the emails of a mailbox
+ * @retval ptr New HeaderPool
+ */
+struct HeaderPool *mutt_header_pool_new(void)
+{
+  struct HeaderPool *pool = mutt_mem_malloc(sizeof(struct HeaderPool));
+  pool->headers = mutt_pool_create(sizeof(struct Header), 256);
+  pool->envelopes = mutt_pool_create(sizeof(struct Envelope), 256);
+  pool->bodies = mutt_pool_create(sizeof(struct Body), 256);
+  return pool;
+}
+
+/**
+ * mutt_header_pool_free - Release the storage for the emails of a mailbox
+ * @param pool HeaderPool to free
+ *
+ * All the Headers, Envelopes and Bodies allocated from the pool must have been
+ * freed, first.
+ */
+void mutt_header_pool_free(struct HeaderPool **pool)
+{
+  if (!pool || !*pool)
+    return;
+
+  mutt_pool_destroy(&(*pool)->headers);
+  mutt_pool_destroy(&(*pool)->envelopes);
+  mutt_pool_destroy(&(*pool)->bodies);
+  FREE(pool);
+}
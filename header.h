@@ -31,6 +31,10 @@
 
 /**
  * struct Header - The header/envelope of an email
+ *
+ * The fields read by every scan of the index (sorting, limiting, colouring and
+ * drawing) come first, so that they share the first cache line.  The rest are
+ * only needed once a message has been selected.
  */
 struct Header
 {
@@ -76,38 +80,40 @@ struct Header
   /* the following are used to support collapsing threads  */
   bool collapsed : 1; /**< is this message part of a collapsed thread? */
   bool limited : 1;   /**< is this message in a limited view?  */
-  size_t num_hidden;  /**< number of hidden messages in this view */
+  bool limit_dirty : 1; /**< flags changed, limit needs re-checking */
 
+  int index;          /**< the absolute (unsorted) message number */
+  int msgno;          /**< number displayed to the user */
+  int virtual;        /**< virtual message number */
+  int score;
+  int pair;           /**< color-pair to use when displaying in the index */
   short recipient;    /**< user_is_recipient()'s return value, cached */
 
-  int pair;           /**< color-pair to use when displaying in the index */
+  /* Number of qualifying attachments in message, if attach_valid */
+  short attach_total;
 
   time_t date_sent;   /**< time when the message was sent (UTC) */
   time_t received;    /**< time when the message was placed in the mailbox */
-  LOFF_T offset;      /**< where in the stream does this message begin? */
-  int lines;          /**< how many lines in the body of this message? */
-  int index;          /**< the absolute (unsorted) message number */
-  int msgno;          /**< number displayed to the user */
-  int virtual;        /**< virtual message number */
-  int score;
   struct Envelope *env;      /**< envelope information */
+  struct MuttThread *thread;
+
+  /* end of the hot fields */
+
   struct Body *content;      /**< list of MIME parts */
+  LOFF_T offset;      /**< where in the stream does this message begin? */
+  size_t num_hidden;  /**< number of hidden messages in this view */
+  int lines;          /**< how many lines in the body of this message? */
+#ifdef USE_POP
+  int refno; /**< message number on server */
+#endif
   char *path;
 
   char *tree; /**< character string to print thread tree */
-  struct MuttThread *thread;
-
-  /* Number of qualifying attachments in message, if attach_valid */
-  short attach_total;
 
 #ifdef MIXMASTER
   struct ListHead chain;
 #endif
 
-#ifdef USE_POP
-  int refno; /**< message number on server */
-#endif
-
   struct TagHead tags; /**< for drivers that support server tagging */
 
 #if defined(USE_POP) || defined(USE_IMAP) || defined(USE_NNTP) || defined(USE_NOTMUCH)
@@ -116,10 +122,35 @@ struct Header
 #endif
 
   char *maildir_flags; /**< unknown maildir flags */
+
+  struct HeaderPool *pool; /**< storage this Header came from, NULL if malloc'd */
+
+  char *index_line;      /**< cached $index_format line, see index_make_entry() */
+  unsigned int index_gen; /**< generation of index_line */
+  int index_flags;       /**< format flags used to build index_line */
+  int index_cols;        /**< screen width used to build index_line */
+};
+
+/**
+ * struct HeaderPool - Storage for the emails of a mailbox
+ *
+ * The Headers of a mailbox, with their Envelopes and top-level Bodies, are
+ * carved out of large chunks rather than malloc'd one by one.  The chunks are
+ * released together when the mailbox is closed.
+ */
+struct HeaderPool
+{
+  struct Pool *headers;   /**< storage for struct Header */
+  struct Pool *envelopes; /**< storage for struct Envelope */
+  struct Pool *bodies;    /**< storage for struct Body */
 };
 
 int mbox_strict_cmp_headers(const struct Header *h1, const struct Header *h2);
 struct Header *mutt_new_header(void);
+struct Header *mutt_new_pooled_header(struct HeaderPool *pool);
 void mutt_free_header(struct Header **h);
 
+struct HeaderPool *mutt_header_pool_new(void);
+void mutt_header_pool_free(struct HeaderPool **pool);
+
 #endif /* _MUTT_HEADER_H */
@@ -76,7 +76,8 @@ static const char *const Capabilities[] = {
   "IMAP4",     "IMAP4rev1",     "STATUS",      "ACL",
   "NAMESPACE", "AUTH=CRAM-MD5", "AUTH=GSSAPI", "AUTH=ANONYMOUS",
   "STARTTLS",  "LOGINDISABLED", "IDLE",        "SASL-IR",
-  "ENABLE",    "X-GM-EXT1",     "X-GM-EXT-1",  NULL,
+  "ENABLE",    "NOTIFY",        "X-GM-EXT1",   "X-GM-EXT-1",
+  NULL,
 };
 
 /**
@@ -636,6 +637,7 @@ static void cmd_parse_status(struct ImapData *idata, char *s)
   long litlen;
   short new = 0;
   short new_msg_count = 0;
+  bool have_unseen = false;
 
   mailbox = imap_next_word(s);
 
@@ -686,12 +688,18 @@ static void cmd_parse_status(struct ImapData *idata, char *s)
     else if (mutt_str_strncmp("UIDVALIDITY", s, 11) == 0)
       status->uidvalidity = count;
     else if (mutt_str_strncmp("UNSEEN", s, 6) == 0)
+    {
       status->unseen = count;
+      have_unseen = true;
+    }
 
     s = value;
     if (*s && *s != ')')
       s = imap_next_word(s);
   }
+  /* a NOTIFY event may only give the new message count, the next
+   * imap_buffy_check() will ask for the rest */
+  status->changed = !have_unseen;
   mutt_debug(
       3,
       "%s (UIDVALIDITY: %d, UIDNEXT: %d) %d messages, %d recent, %d unseen\n",
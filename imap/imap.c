@@ -1051,6 +1051,8 @@ int imap_open_connection(struct ImapData *idata)
     return -1;
 
   idata->state = IMAP_CONNECTED;
+  /* a new connection has no NOTIFY in effect */
+  FREE(&idata->notify);
 
   if (imap_cmd_step(idata) != IMAP_CMD_OK)
   {
@@ -1453,6 +1455,140 @@ int imap_check(struct ImapData *idata, int force)
   return result;
 }
 
+/**
+ * mboxcache_find - Find the cached status of a mailbox
+ * @param idata Server data
+ * @param mbox  Mailbox name
+ * @retval ptr  Status of the mailbox
+ * @retval NULL The server hasn't told us about it yet
+ *
+ * Unlike imap_mboxcache_get(), the header cache isn't consulted.
+ */
+static struct ImapStatus *mboxcache_find(struct ImapData *idata, const char *mbox)
+{
+  struct ListNode *np = NULL;
+  STAILQ_FOREACH(np, &idata->mboxcache, entries)
+  {
+    struct ImapStatus *status = (struct ImapStatus *) np->data;
+    if (imap_mxcmp(mbox, status->name) == 0)
+      return status;
+  }
+
+  return NULL;
+}
+
+/**
+ * notify_mailboxes - List an account's mailboxes for NOTIFY
+ * @param idata Server data
+ * @retval ptr Space-separated list of munged mailbox names, or NULL if none
+ *
+ * The caller must free the returned string.
+ */
+static char *notify_mailboxes(struct ImapData *idata)
+{
+  struct ImapMbox mx;
+  struct Buffer *list = mutt_buffer_new();
+  char name[LONG_STRING];
+  char munged[LONG_STRING];
+  char *rc = NULL;
+
+  for (struct Buffy *b = Incoming; b; b = b->next)
+  {
+    if (b->magic != MUTT_IMAP)
+      continue;
+
+    if (imap_parse_path(b->path, &mx) < 0)
+      continue;
+
+    if (imap_account_match(&idata->conn->account, &mx.account))
+    {
+      imap_fix_path(idata, mx.mbox, name, sizeof(name));
+      if (!*name)
+        mutt_str_strfcpy(name, "INBOX", sizeof(name));
+      imap_munge_mbox_name(idata, munged, sizeof(munged), name);
+      if (list->dptr != list->data)
+        mutt_buffer_addch(list, ' ');
+      mutt_buffer_addstr(list, munged);
+    }
+    FREE(&mx.mbox);
+  }
+
+  if (list->data && *list->data)
+    rc = mutt_str_strdup(list->data);
+  mutt_buffer_free(&list);
+
+  return rc;
+}
+
+/**
+ * imap_notify_update - Ask the servers to tell us about changed mailboxes
+ *
+ * If a server supports NOTIFY (RFC5465), it's given the list of mailboxes we
+ * are interested in.  It then sends a STATUS whenever one of them changes, so
+ * imap_buffy_check() only needs to ask about those.  Any pending
+ * notifications are read, without waiting.
+ */
+static void imap_notify_update(void)
+{
+  struct Connection *conn = NULL;
+  char *cmd = NULL;
+
+  TAILQ_FOREACH(conn, mutt_socket_head(), entries)
+  {
+    if (conn->account.type != MUTT_ACCT_TYPE_IMAP)
+      continue;
+
+    struct ImapData *idata = conn->data;
+    if (!idata || (idata->state < IMAP_AUTHENTICATED))
+      continue;
+
+    if (!option(OPT_IMAP_NOTIFY) || !mutt_bit_isset(idata->capabilities, NOTIFY))
+    {
+      FREE(&idata->notify);
+      continue;
+    }
+
+    char *list = notify_mailboxes(idata);
+    if (mutt_str_strcmp(list, idata->notify) != 0)
+    {
+      if (list)
+      {
+        const char *events = "(MessageNew MessageExpunge FlagChange)";
+        size_t len = mutt_str_strlen(list) + 128;
+        cmd = mutt_mem_malloc(len);
+        snprintf(cmd, len, "NOTIFY SET STATUS (selected %s) (mailboxes (%s) %s)",
+                 events, list, events);
+      }
+      else
+        cmd = mutt_str_strdup("NOTIFY NONE");
+
+      FREE(&idata->notify);
+      if (imap_exec(idata, cmd, IMAP_CMD_FAIL_OK) == 0)
+      {
+        idata->notify = list;
+        list = NULL;
+      }
+      else
+      {
+        mutt_debug(1, "NOTIFY failed, falling back to STATUS polling\n");
+        mutt_bit_unset(idata->capabilities, NOTIFY);
+      }
+      FREE(&cmd);
+    }
+    FREE(&list);
+
+    if (!idata->notify)
+      continue;
+
+    /* read the STATUS notifications that have arrived */
+    while (mutt_socket_poll(idata->conn, 0) > 0)
+    {
+      if (imap_cmd_step(idata) != IMAP_CMD_CONTINUE)
+        break;
+    }
+  }
+}
+
 /**
  * imap_buffy_check - Check for new mail in subscribed folders
  * @param force       Force an update
@@ -1476,15 +1612,17 @@ int imap_buffy_check(int force, int check_stats)
   char munged[LONG_STRING];
   int buffies = 0;
 
+  /* Init newly-added mailboxes */
   for (mailbox = Incoming; mailbox; mailbox = mailbox->next)
   {
-    /* Init newly-added mailboxes */
-    if (!mailbox->magic)
-    {
-      if (mx_is_imap(mailbox->path))
-        mailbox->magic = MUTT_IMAP;
-    }
+    if (!mailbox->magic && mx_is_imap(mailbox->path))
+      mailbox->magic = MUTT_IMAP;
+  }
+
+  imap_notify_update();
 
+  for (mailbox = Incoming; mailbox; mailbox = mailbox->next)
+  {
     if (mailbox->magic != MUTT_IMAP)
       continue;
 
@@ -1501,9 +1639,22 @@ int imap_buffy_check(int force, int check_stats)
     if (idata->mailbox && (imap_mxcmp(name, idata->mailbox) == 0))
     {
       mailbox->new = false;
+      /* NOTIFY won't send a STATUS for the selected mailbox, so ask again
+       * once it's been closed */
+      struct ImapStatus *status = mboxcache_find(idata, name);
+      if (status)
+        status->changed = true;
       continue;
     }
 
+    /* NOTIFY hasn't said anything has changed since the last STATUS */
+    if (!force && idata->notify)
+    {
+      struct ImapStatus *status = mboxcache_find(idata, name);
+      if (status && !status->changed)
+        continue;
+    }
+
     if (!mutt_bit_isset(idata->capabilities, IMAP4REV1) &&
         !mutt_bit_isset(idata->capabilities, STATUS))
     {
@@ -1646,6 +1797,8 @@ struct ImapStatus *imap_mboxcache_get(struct ImapData *idata, const char *mbox,
   {
     struct ImapStatus *scache = mutt_mem_calloc(1, sizeof(struct ImapStatus));
     scache->name = (char *) mbox;
+    /* nothing is known about it yet */
+    scache->changed = true;
     mutt_list_insert_tail(&idata->mboxcache, (char *) scache);
     status = imap_mboxcache_get(idata, mbox, 0);
     status->name = mutt_str_strdup(mbox);
@@ -2321,6 +2474,12 @@ static int imap_close_mailbox(struct Context *ctx)
       idata->state = IMAP_AUTHENTICATED;
     }
 
+    /* NOTIFY doesn't report on the selected mailbox, so its counts must
+     * be fetched again by the next imap_buffy_check() */
+    struct ImapStatus *status = imap_mboxcache_get(idata, idata->mailbox, false);
+    if (status)
+      status->changed = true;
+
     idata->reopen &= IMAP_REOPEN_ALLOW;
     FREE(&(idata->mailbox));
     mutt_list_free(&idata->flags);
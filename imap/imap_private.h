@@ -135,6 +135,7 @@ enum ImapCaps
   IDLE,          /**< RFC2177: IDLE */
   SASL_IR,       /**< SASL initial response draft */
   ENABLE,        /**< RFC5161 */
+  NOTIFY,        /**< RFC5465: NOTIFY */
   X_GM_EXT1,     /**< https://developers.google.com/gmail/imap/imap-extensions */
   X_GM_ALT1 = X_GM_EXT1, /**< Alternative capability string */
 
@@ -166,6 +167,8 @@ struct ImapStatus
   unsigned int uidnext;
   unsigned int uidvalidity;
   unsigned int unseen;
+
+  bool changed; /**< counts may be out of date, e.g. NOTIFY gave no unseen count */
 };
 
 /**
@@ -219,6 +222,7 @@ struct ImapData
    * it's just no fun to get the same information twice */
   char *capstr;
   unsigned char capabilities[(CAPMAX + 7) / 8];
+  char *notify; /**< mailboxes given to NOTIFY SET, NULL if it isn't in use */
   unsigned int seqno;
   time_t lastread; /**< last time we read a command for the server */
   char *buf;
@@ -2844,6 +2844,9 @@ static int parse_set(struct Buffer *tmp, struct Buffer *s, unsigned long data,
           case MUTT_MAILDIR:
             p = "Maildir";
             break;
+          case MUTT_ZMBOX:
+            p = "zmbox";
+            break;
           default:
             p = "unknown";
             break;
@@ -3302,6 +3305,10 @@ int mutt_parse_rc_line(/* const */ char *line, struct Buffer *token, struct Buff
 
   *err->data = 0;
 
+  /* any command may change the look of the index */
+  mutt_index_line_invalidate(NULL);
+  mutt_menu_forget_rows();
+
   SKIPWS(expn.dptr);
   while (*expn.dptr)
   {
@@ -3854,6 +3861,9 @@ int var_to_string(int idx, char *val, size_t len)
       case MUTT_MAILDIR:
         p = "Maildir";
         break;
+      case MUTT_ZMBOX:
+        p = "zmbox";
+        break;
       default:
         p = "unknown";
     }
@@ -1423,6 +1423,16 @@ struct Option MuttVars[] = {
   ** .pp
   ** This variable defaults to the value of $$imap_user.
   */
+  { "imap_notify",              DT_BOOL, R_NONE, OPT_IMAP_NOTIFY, 1 },
+  /*
+  ** .pp
+  ** When \fIset\fP, NeoMutt will use the IMAP NOTIFY extension (RFC5465), if
+  ** the server supports it, to be told when the mailboxes in your
+  ** ``$mailboxes'' list change.  Only the mailboxes that have changed are
+  ** checked with STATUS, instead of all of them every $$mail_check seconds.
+  ** .pp
+  ** Unset this if your server's NOTIFY support is unreliable.
+  */
   { "imap_pass",        DT_STRING,  R_NONE|F_SENSITIVE, UL &ImapPass, UL 0 },
   /*
   ** .pp
@@ -1657,6 +1667,19 @@ struct Option MuttVars[] = {
   ** from your spool mailbox to your $$mbox mailbox, or as a result of
   ** a ``$mbox-hook'' command.
   */
+  { "limit_refresh",    DT_BOOL, R_NONE, OPT_LIMIT_REFRESH, 0 },
+  /*
+  ** .pp
+  ** When \fIset\fP, a message whose flags change (e.g. it is read, deleted or
+  ** tagged) is checked against the current limit pattern again.  If it no
+  ** longer matches, it is removed from the view; if it now matches, it is
+  ** added.  When \fIunset\fP, the limited view only changes when new mail
+  ** arrives or the limit is changed.
+  ** .pp
+  ** Only the changed messages are tested.  If the limit pattern looks at
+  ** other messages, e.g. ``~(...)'', ``~<(...)'', ``~>(...)'', ``~='' or
+  ** ``~$'', every message is tested again.
+  */
   { "mail_check",       DT_NUMBER,  R_NONE, UL &MailCheck, 5 },
   /*
   ** .pp
@@ -1779,6 +1802,10 @@ struct Option MuttVars[] = {
   ** The default mailbox type used when creating new folders. May be any of
   ** ``mbox'', ``MMDF'', ``MH'' and ``Maildir''. This is overridden by the
   ** \fC-m\fP command-line option.
+  ** .pp
+  ** If NeoMutt was built with zlib, it may also be ``zmbox'', a compressed
+  ** archive that can be read without decompressing all of it.  Each message
+  ** is compressed separately, so the file can still be read by \fCgzip -d\fP.
   */
   { "menu_context",     DT_NUMBER,  R_NONE, UL &MenuContext, 0 },
   /*
@@ -1810,6 +1837,39 @@ struct Option MuttVars[] = {
   ** every once in a while, since it can be a little slow
   ** (especially for large folders).
   */
+  { "message_cache_dedup", DT_BOOL, R_NONE, OPT_MESSAGE_CACHE_DEDUP, 0 },
+  /*
+  ** .pp
+  ** If \fIset\fP, a message that is cached more than once, e.g. because it
+  ** was delivered to several folders, is stored only once.  The copies are
+  ** hard links to a single file in the ``.objects'' directory of
+  ** $$message_cachedir.
+  ** .pp
+  ** This doesn't apply to caches stored in packs, see $$message_cache_packed.
+  */
+  { "message_cache_packed", DT_BOOL, R_NONE, OPT_MESSAGE_CACHE_PACKED, 0 },
+  /*
+  ** .pp
+  ** If \fIset\fP, the cached messages of each mailbox are appended to a single
+  ** pack file, with an index, instead of being stored one per file.  This
+  ** saves inodes and directory lookups when a lot of messages are cached.
+  ** When more than half of a pack belongs to messages that have been deleted,
+  ** it is compacted as the mailbox is closed.
+  ** .pp
+  ** Messages cached the other way aren't seen, so changing this starts a new
+  ** cache.  $$message_cache_size removes whole packs, least recently used
+  ** first.
+  */
+  { "message_cache_size", DT_NUMBER, R_NONE, UL &MessageCacheSize, 0 },
+  /*
+  ** .pp
+  ** The largest size, in megabytes, that $$message_cachedir may grow to.
+  ** When it gets bigger, the messages that haven't been read for the longest
+  ** time are removed from the cache until it is back under 90% of the limit.
+  ** The limit covers the whole directory, which is shared by all accounts.
+  ** .pp
+  ** If zero, the cache can grow without limit.
+  */
   { "message_cachedir", DT_PATH,        R_NONE, UL &MessageCachedir, 0 },
   /*
   ** .pp
@@ -1821,7 +1881,8 @@ struct Option MuttVars[] = {
   ** remote message only once and can perform regular expression searches
   ** as fast as for local folders.
   ** .pp
-  ** Also see the $$message_cache_clean variable.
+  ** Also see the $$message_cache_clean, $$message_cache_dedup,
+  ** $$message_cache_packed and $$message_cache_size variables.
   */
 #endif
   { "message_format",   DT_STRING,  R_NONE, UL &MessageFormat, UL "%s" },
@@ -40,6 +40,9 @@
 #ifdef USE_IMAP
 #include "imap/imap.h"
 #endif
+#ifdef USE_INOTIFY
+#include "monitor.h"
+#endif
 
 const struct Mapping Menus[] = {
   { "alias", MENU_ALIAS },
@@ -492,24 +495,29 @@ int km_dokey(int menu)
       else
         while (ImapKeepalive && ImapKeepalive < i)
         {
-          timeout(ImapKeepalive * 1000);
+          mutt_getch_timeout(ImapKeepalive * 1000);
           tmp = mutt_getch();
-          timeout(-1);
+          mutt_getch_timeout(-1);
           /* If a timeout was not received, or the window was resized, exit the
            * loop now.  Otherwise, continue to loop until reaching a total of
            * $timeout seconds.
            */
           if (tmp.ch != -2 || SigWinch)
             goto gotkey;
+#ifdef USE_INOTIFY
+          /* a watched mailbox has changed */
+          if (MonitorFilesChanged || MonitorContextChanged)
+            goto gotkey;
+#endif
           i -= ImapKeepalive;
           imap_keepalive();
         }
     }
 #endif
 
-    timeout(i * 1000);
+    mutt_getch_timeout(i * 1000);
     tmp = mutt_getch();
-    timeout(-1);
+    mutt_getch_timeout(-1);
 
 #ifdef USE_IMAP
   gotkey:
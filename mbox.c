@@ -51,6 +51,9 @@
 #include "rfc822.h"
 #include "sort.h"
 #include "thread.h"
+#ifdef USE_ZLIB
+#include "zmbox.h"
+#endif
 
 /**
  * struct MUpdate - Store of new offsets, used by mutt_sync_mailbox()
@@ -97,6 +100,34 @@ static void mbox_unlock_mailbox(struct Context *ctx)
   }
 }
 
+/**
+ * mbox_stat - Save the size and times of a mailbox's file
+ * @param ctx Mailbox
+ * @retval  0 Success
+ * @retval -1 Error
+ *
+ * A mailbox read by mbox_open_stream() has no file of its own, so its size
+ * is left as it was set.
+ */
+static int mbox_stat(struct Context *ctx)
+{
+  struct stat sb;
+
+  if (fileno(ctx->fp) == -1)
+    return 0;
+
+  if (stat(ctx->path, &sb) == -1)
+  {
+    mutt_perror(ctx->path);
+    return -1;
+  }
+
+  ctx->size = sb.st_size;
+  ctx->mtime = sb.st_mtime;
+  ctx->atime = sb.st_atime;
+  return 0;
+}
+
 static int mmdf_parse_mailbox(struct Context *ctx)
 {
   char buf[HUGE_STRING];
@@ -106,18 +137,11 @@ static int mmdf_parse_mailbox(struct Context *ctx)
   time_t t;
   LOFF_T loc, tmploc;
   struct Header *hdr = NULL;
-  struct stat sb;
   struct Progress progress;
   char msgbuf[STRING];
 
-  if (stat(ctx->path, &sb) == -1)
-  {
-    mutt_perror(ctx->path);
+  if (mbox_stat(ctx) != 0)
     return -1;
-  }
-  ctx->atime = sb.st_atime;
-  ctx->mtime = sb.st_mtime;
-  ctx->size = sb.st_size;
 
   buf[sizeof(buf) - 1] = '\0';
 
@@ -147,7 +171,7 @@ static int mmdf_parse_mailbox(struct Context *ctx)
 
       if (ctx->msgcount == ctx->hdrmax)
         mx_alloc_memory(ctx);
-      ctx->hdrs[ctx->msgcount] = hdr = mutt_new_header();
+      ctx->hdrs[ctx->msgcount] = hdr = mutt_new_pooled_header(ctx->hdr_pool);
       hdr->offset = loc;
       hdr->index = ctx->msgcount;
 
@@ -255,7 +279,6 @@ static int mmdf_parse_mailbox(struct Context *ctx)
  */
 static int mbox_parse_mailbox(struct Context *ctx)
 {
-  struct stat sb;
   char buf[HUGE_STRING], return_path[STRING];
   struct Header *curhdr = NULL;
   time_t t;
@@ -265,15 +288,8 @@ static int mbox_parse_mailbox(struct Context *ctx)
   char msgbuf[STRING];
 
   /* Save information about the folder at the time we opened it. */
-  if (stat(ctx->path, &sb) == -1)
-  {
-    mutt_perror(ctx->path);
+  if (mbox_stat(ctx) != 0)
     return -1;
-  }
-
-  ctx->size = sb.st_size;
-  ctx->mtime = sb.st_mtime;
-  ctx->atime = sb.st_atime;
 
   if (!ctx->readonly)
     ctx->readonly = access(ctx->path, W_OK) ? true : false;
@@ -312,7 +328,7 @@ static int mbox_parse_mailbox(struct Context *ctx)
       if (ctx->msgcount == ctx->hdrmax)
         mx_alloc_memory(ctx);
 
-      curhdr = ctx->hdrs[ctx->msgcount] = mutt_new_header();
+      curhdr = ctx->hdrs[ctx->msgcount] = mutt_new_pooled_header(ctx->hdr_pool);
       curhdr->received = t - mutt_date_local_tz(t);
       curhdr->offset = loc;
       curhdr->index = ctx->msgcount;
@@ -466,6 +482,46 @@ static int mbox_open_mailbox(struct Context *ctx)
   return rc;
 }
 
+/**
+ * mbox_open_stream - Read a mbox or mmdf mailbox from a stream
+ * @param ctx  Mailbox
+ * @param fp   Stream of the mailbox's contents
+ * @param size Size of the contents
+ * @retval  0 Success
+ * @retval -1 Error
+ * @retval -2 Aborted by the user
+ *
+ * This is for mailboxes that aren't stored in a file of their own, e.g. a
+ * compressed folder being decompressed on the fly.  The stream must be
+ * seekable, but needn't have a file descriptor, so the mailbox isn't locked.
+ *
+ * If the contents aren't a mbox or mmdf mailbox, -1 is returned and the
+ * stream still belongs to the caller.  Otherwise, it belongs to the Context.
+ */
+int mbox_open_stream(struct Context *ctx, FILE *fp, LOFF_T size)
+{
+  char buf[STRING];
+
+  if (!fgets(buf, sizeof(buf), fp) || (fseeko(fp, 0, SEEK_SET) != 0))
+    return -1;
+
+  if (mutt_str_strncmp("From ", buf, 5) == 0)
+    ctx->magic = MUTT_MBOX;
+  else if (mutt_str_strcmp(MMDF_SEP, buf) == 0)
+    ctx->magic = MUTT_MMDF;
+  else
+    return -1;
+
+  ctx->fp = fp;
+  ctx->size = size;
+  ctx->readonly = true;
+
+  if (ctx->magic == MUTT_MBOX)
+    return mbox_parse_mailbox(ctx);
+  else
+    return mmdf_parse_mailbox(ctx);
+}
+
 static int mbox_open_mailbox_append(struct Context *ctx, int flags)
 {
   ctx->fp = mutt_file_fopen(ctx->path, flags & MUTT_NEWFOLDER ? "w" : "a");
@@ -660,7 +716,18 @@ int mbox_strict_cmp_headers(const struct Header *h1, const struct Header *h2)
   }
 }
 
-static int reopen_mailbox(struct Context *ctx, int *index_hint)
+/**
+ * mbox_reopen_mailbox - Read a mailbox again, keeping the flags
+ * @param[in]  ctx        Mailbox
+ * @param[out] index_hint Keep track of current index selection
+ * @retval #MUTT_REOPENED  Messages have changed
+ * @retval #MUTT_NEW_MAIL  Messages have only been added
+ * @retval -1              Error
+ *
+ * This is for mailboxes stored in a single file, that have been changed by
+ * another program.
+ */
+int mbox_reopen_mailbox(struct Context *ctx, int *index_hint)
 {
   int (*cmp_headers)(const struct Header *, const struct Header *) = NULL;
   struct Header **old_hdrs = NULL;
@@ -738,6 +805,13 @@ static int reopen_mailbox(struct Context *ctx, int *index_hint)
         rc = ((ctx->magic == MUTT_MBOX) ? mbox_parse_mailbox : mmdf_parse_mailbox)(ctx);
       break;
 
+#ifdef USE_ZLIB
+    case MUTT_ZMBOX:
+      cmp_headers = mbox_strict_cmp_headers;
+      rc = zmbox_reread_mailbox(ctx);
+      break;
+#endif
+
     default:
       rc = -1;
       break;
@@ -933,7 +1007,7 @@ static int mbox_check_mailbox(struct Context *ctx, int *index_hint)
 
   if (modified)
   {
-    if (reopen_mailbox(ctx, index_hint) != -1)
+    if (mbox_reopen_mailbox(ctx, index_hint) != -1)
     {
       if (unlock)
       {
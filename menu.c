@@ -284,6 +284,92 @@ static void menu_make_entry(char *s, int l, struct Menu *menu, int i)
     menu->make_entry(s, l, menu, i);
 }
 
+/**
+ * struct MenuRow - A row of a menu, as it was last drawn
+ */
+struct MenuRow
+{
+  char *text;    /**< entry text, NULL if the row was cleared */
+  int attr;      /**< colour of the entry */
+  int indicator; /**< colour of the indicator, -1 if not the current entry */
+  int entry;     /**< entry drawn, -1 if unknown */
+};
+
+/* Bumped whenever the screen is cleared, or the look of rows may have
+ * changed without their text changing, see mutt_menu_forget_rows() */
+static unsigned int ScreenGen = 1;
+
+/**
+ * mutt_menu_forget_rows - Forget what every menu has drawn
+ *
+ * Call this after clearing the screen or changing any setting that changes
+ * how rows are drawn.  Every menu will then repaint all of its rows.
+ */
+void mutt_menu_forget_rows(void)
+{
+  if (++ScreenGen == 0)
+    ScreenGen = 1;
+}
+
+/**
+ * menu_forget_row - Forget what was drawn on one row
+ * @param menu Menu
+ * @param i    Entry drawn outside of menu_redraw_index()
+ */
+static void menu_forget_row(struct Menu *menu, int i)
+{
+  int row = i - menu->top;
+
+  if ((row >= 0) && (row < menu->rows_len))
+    menu->rows[row].entry = -1;
+}
+
+/**
+ * menu_row_unchanged - Has this row already been drawn like this?
+ * @param menu      Menu
+ * @param row       Row of the page
+ * @param entry     Entry number, -1 for an empty row
+ * @param text      Entry text, NULL for an empty row
+ * @param attr      Colour of the entry
+ * @param indicator Colour of the indicator, -1 if not the current entry
+ * @retval true If the screen already shows exactly this
+ *
+ * If the row has changed, it is remembered as drawn.
+ */
+static bool menu_row_unchanged(struct Menu *menu, int row, int entry,
+                               const char *text, int attr, int indicator)
+{
+  if ((menu->rows_gen != ScreenGen) || (menu->rows_len != menu->pagelen))
+  {
+    for (int i = 0; i < menu->rows_len; i++)
+      FREE(&menu->rows[i].text);
+    mutt_mem_realloc(&menu->rows, menu->pagelen * sizeof(struct MenuRow));
+    for (int i = 0; i < menu->pagelen; i++)
+    {
+      menu->rows[i].text = NULL;
+      menu->rows[i].entry = -1;
+    }
+    menu->rows_len = menu->pagelen;
+    menu->rows_gen = ScreenGen;
+  }
+
+  if ((row < 0) || (row >= menu->rows_len))
+    return false;
+
+  struct MenuRow *r = &menu->rows[row];
+  if ((r->entry != -1) && (r->entry == entry) && (r->attr == attr) &&
+      (r->indicator == indicator) && (mutt_str_strcmp(r->text, text) == 0))
+  {
+    return true;
+  }
+
+  mutt_str_replace(&r->text, text);
+  r->entry = entry;
+  r->attr = attr;
+  r->indicator = indicator;
+  return false;
+}
+
 static void menu_pad_string(struct Menu *menu, char *s, size_t n)
 {
   char *scratch = mutt_str_strdup(s);
@@ -304,6 +390,7 @@ void menu_redraw_full(struct Menu *menu)
   /* clear() doesn't optimize screen redraws */
   move(0, 0);
   clrtobot();
+  mutt_menu_forget_rows();
 
   if (option(OPT_HELP))
   {
@@ -348,6 +435,8 @@ void menu_redraw_index(struct Menu *menu)
   char buf[LONG_STRING];
   bool do_color;
   int attr;
+  int drawn = 0;
+  size_t bytes = 0;
 
   for (int i = menu->top; i < menu->top + menu->pagelen; i++)
   {
@@ -356,7 +445,15 @@ void menu_redraw_index(struct Menu *menu)
       attr = menu->color(i);
 
       menu_make_entry(buf, sizeof(buf), menu, i);
+
+      /* the indicator may be hidden by menu_make_entry() */
+      int indicator = (i == menu->current) ? ColorDefs[MT_COLOR_INDICATOR] : -1;
+      if (menu_row_unchanged(menu, i - menu->top, i, buf, attr, indicator))
+        continue;
+
       menu_pad_string(menu, buf, sizeof(buf));
+      drawn++;
+      bytes += mutt_str_strlen(buf);
 
       ATTRSET(attr);
       mutt_window_move(menu->indexwin, i - menu->top + menu->offset, 0);
@@ -381,12 +478,18 @@ void menu_redraw_index(struct Menu *menu)
     }
     else
     {
+      if (menu_row_unchanged(menu, i - menu->top, -2, NULL, 0, -1))
+        continue;
+
       NORMAL_COLOR;
       mutt_window_clearline(menu->indexwin, i - menu->top + menu->offset);
+      drawn++;
     }
   }
   NORMAL_COLOR;
   menu->redraw = 0;
+
+  mutt_debug(5, "redrew %d of %d rows, %zu bytes\n", drawn, menu->pagelen, bytes);
 }
 
 void menu_redraw_motion(struct Menu *menu)
@@ -405,6 +508,8 @@ void menu_redraw_motion(struct Menu *menu)
    * generate status messages.  So we want to call it *before* we
    * position the cursor for drawing. */
   old_color = menu->color(menu->oldcurrent);
+  menu_forget_row(menu, menu->oldcurrent);
+  menu_forget_row(menu, menu->current);
   mutt_window_move(menu->indexwin, menu->oldcurrent + menu->offset - menu->top, 0);
   ATTRSET(old_color);
 
@@ -449,6 +554,7 @@ void menu_redraw_current(struct Menu *menu)
   char buf[LONG_STRING];
   int attr = menu->color(menu->current);
 
+  menu_forget_row(menu, menu->current);
   mutt_window_move(menu->indexwin, menu->current + menu->offset - menu->top, 0);
   menu_make_entry(buf, sizeof(buf), menu, menu->current);
   menu_pad_string(menu, buf, sizeof(buf));
@@ -831,6 +937,10 @@ void mutt_menu_destroy(struct Menu **p)
     FREE(&(*p)->dialog);
   }
 
+  for (int i = 0; i < (*p)->rows_len; i++)
+    FREE(&(*p)->rows[i].text);
+  FREE(&(*p)->rows);
+
   FREE(p);
 }
 
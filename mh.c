@@ -89,6 +89,20 @@ struct MhSequences
   short *flags;
 };
 
+/**
+ * struct MaildirListing - Names of the files in a maildir subdirectory
+ *
+ * The names are kept sorted, so that two listings can be compared with a
+ * single merge.
+ */
+struct MaildirListing
+{
+  char **names; /**< file names, sorted with strcmp() */
+  size_t count; /**< number of names */
+  size_t max;   /**< size of the names array */
+  bool valid;   /**< the listing matches the messages in the Context */
+};
+
 /**
  * struct MhData - MH-specific mailbox data
  */
@@ -96,6 +110,7 @@ struct MhData
 {
   time_t mtime_cur;
   mode_t mh_umask;
+  struct MaildirListing listing[2]; /**< maildir "new" and "cur" subdirectories */
 };
 
 /* mh_sequences support */
@@ -832,6 +847,38 @@ struct Header *maildir_parse_message(int magic, const char *fname, bool is_old,
   return NULL;
 }
 
+/**
+ * maildir_new_entry - Create an unparsed Maildir entry for a file
+ * @param ctx    Mailbox
+ * @param subdir Subdirectory of the file, or NULL for MH
+ * @param name   Name of the file
+ * @param is_old Mark the message as old
+ * @param inode  Inode of the file, or 0 if unknown
+ * @retval ptr New entry
+ */
+static struct Maildir *maildir_new_entry(struct Context *ctx, const char *subdir,
+                                         const char *name, int is_old, ino_t inode)
+{
+  struct Header *h = mutt_new_pooled_header(ctx->hdr_pool);
+  h->old = is_old;
+  if (ctx->magic == MUTT_MAILDIR)
+    maildir_parse_flags(h, name);
+
+  if (subdir)
+  {
+    char tmp[LONG_STRING];
+    snprintf(tmp, sizeof(tmp), "%s/%s", subdir, name);
+    h->path = mutt_str_strdup(tmp);
+  }
+  else
+    h->path = mutt_str_strdup(name);
+
+  struct Maildir *entry = mutt_mem_calloc(1, sizeof(struct Maildir));
+  entry->h = h;
+  entry->inode = inode;
+  return entry;
+}
+
 static int maildir_parse_dir(struct Context *ctx, struct Maildir ***last,
                              const char *subdir, int *count, struct Progress *progress)
 {
@@ -840,7 +887,6 @@ static int maildir_parse_dir(struct Context *ctx, struct Maildir ***last,
   char buf[_POSIX_PATH_MAX];
   int is_old = 0;
   struct Maildir *entry = NULL;
-  struct Header *h = NULL;
 
   if (subdir)
   {
@@ -863,11 +909,6 @@ static int maildir_parse_dir(struct Context *ctx, struct Maildir ***last,
     /* FOO - really ignore the return value? */
     mutt_debug(2, "%s:%d: queueing %s\n", __FILE__, __LINE__, de->d_name);
 
-    h = mutt_new_header();
-    h->old = is_old;
-    if (ctx->magic == MUTT_MAILDIR)
-      maildir_parse_flags(h, de->d_name);
-
     if (count)
     {
       (*count)++;
@@ -875,18 +916,7 @@ static int maildir_parse_dir(struct Context *ctx, struct Maildir ***last,
         mutt_progress_update(progress, *count, -1);
     }
 
-    if (subdir)
-    {
-      char tmp[LONG_STRING];
-      snprintf(tmp, sizeof(tmp), "%s/%s", subdir, de->d_name);
-      h->path = mutt_str_strdup(tmp);
-    }
-    else
-      h->path = mutt_str_strdup(de->d_name);
-
-    entry = mutt_mem_calloc(1, sizeof(struct Maildir));
-    entry->h = h;
-    entry->inode = de->d_ino;
+    entry = maildir_new_entry(ctx, subdir, de->d_name, is_old, de->d_ino);
     **last = entry;
     *last = &entry->next;
   }
@@ -902,6 +932,149 @@ static int maildir_parse_dir(struct Context *ctx, struct Maildir ***last,
   return 0;
 }
 
+/**
+ * maildir_listing_free - Forget a directory listing
+ * @param l Listing
+ */
+static void maildir_listing_free(struct MaildirListing *l)
+{
+  for (size_t i = 0; i < l->count; i++)
+    FREE(&l->names[i]);
+  FREE(&l->names);
+  l->count = 0;
+  l->max = 0;
+  l->valid = false;
+}
+
+/**
+ * maildir_listing_add - Add a file name to a directory listing
+ * @param l    Listing
+ * @param name File name
+ */
+static void maildir_listing_add(struct MaildirListing *l, const char *name)
+{
+  if (l->count == l->max)
+  {
+    l->max = l->max ? l->max * 2 : 64;
+    mutt_mem_realloc(&l->names, l->max * sizeof(char *));
+  }
+  l->names[l->count++] = mutt_str_strdup(name);
+}
+
+static int listing_cmp(const void *a, const void *b)
+{
+  return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+/**
+ * maildir_listing_sort - Sort a directory listing, ready for comparison
+ * @param l Listing
+ */
+static void maildir_listing_sort(struct MaildirListing *l)
+{
+  if (l->count > 1)
+    qsort(l->names, l->count, sizeof(char *), listing_cmp);
+  l->valid = true;
+}
+
+/**
+ * maildir_listing_has_canon - Might a listing hold a message's file
+ * @param l     Listing
+ * @param canon Canonical name of the message, see maildir_canon_filename()
+ * @retval true The listing has a file with that name, or isn't valid
+ *
+ * The names sharing a canonical name are next to each other in the sorted
+ * listing, so this is a binary search.
+ */
+static bool maildir_listing_has_canon(const struct MaildirListing *l, const char *canon)
+{
+  if (!l->valid)
+    return true;
+
+  size_t len = mutt_str_strlen(canon);
+  size_t lo = 0, hi = l->count;
+  while (lo < hi)
+  {
+    size_t mid = lo + (hi - lo) / 2;
+    if (strcmp(l->names[mid], canon) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  for (; (lo < l->count) && (strncmp(l->names[lo], canon, len) == 0); lo++)
+  {
+    if ((l->names[lo][len] == ':') || (l->names[lo][len] == '\0'))
+      return true;
+  }
+
+  return false;
+}
+
+/**
+ * maildir_listing_read - List the files in a maildir subdirectory
+ * @param ctx    Mailbox
+ * @param subdir Subdirectory, "new" or "cur"
+ * @param l      Listing to fill
+ * @retval  0 Success
+ * @retval -1 Error
+ * @retval -2 Aborted by the user
+ */
+static int maildir_listing_read(struct Context *ctx, const char *subdir,
+                                struct MaildirListing *l)
+{
+  char buf[_POSIX_PATH_MAX];
+  struct dirent *de = NULL;
+
+  snprintf(buf, sizeof(buf), "%s/%s", ctx->path, subdir);
+  DIR *dirp = opendir(buf);
+  if (!dirp)
+    return -1;
+
+  while (((de = readdir(dirp)) != NULL) && (SigInt != 1))
+  {
+    if (*de->d_name != '.')
+      maildir_listing_add(l, de->d_name);
+  }
+
+  closedir(dirp);
+
+  if (SigInt == 1)
+  {
+    SigInt = 0;
+    maildir_listing_free(l);
+    return -2;
+  }
+
+  maildir_listing_sort(l);
+  return 0;
+}
+
+/**
+ * maildir_listing_store - Remember the files found by a full scan
+ * @param data    Mailbox data
+ * @param changed Subdirectories that were scanned, 0x1 = new, 0x2 = cur
+ * @param md      Messages found
+ */
+static void maildir_listing_store(struct MhData *data, int changed, struct Maildir *md)
+{
+  static const char *const subdirs[] = { "new/", "cur/" };
+
+  for (int i = 0; i < 2; i++)
+  {
+    if (!(changed & (1 << i)))
+      continue;
+
+    maildir_listing_free(&data->listing[i]);
+    for (struct Maildir *p = md; p; p = p->next)
+    {
+      if (p->h && (strncmp(p->h->path, subdirs[i], 4) == 0))
+        maildir_listing_add(&data->listing[i], p->h->path + 4);
+    }
+    maildir_listing_sort(&data->listing[i]);
+  }
+}
+
 static bool maildir_add_to_context(struct Context *ctx, struct Maildir *md)
 {
   int oldmsgcount = ctx->msgcount;
@@ -1242,6 +1415,13 @@ static void maildir_delayed_parsing(struct Context *ctx, struct Maildir **md,
 
 static int mh_close_mailbox(struct Context *ctx)
 {
+  struct MhData *data = mh_data(ctx);
+
+  if (data)
+  {
+    maildir_listing_free(&data->listing[0]);
+    maildir_listing_free(&data->listing[1]);
+  }
   FREE(&ctx->data);
 
   return 0;
@@ -2022,6 +2202,191 @@ static void maildir_update_tables(struct Context *ctx, int *index_hint)
   mutt_clear_threads(ctx);
 }
 
+/**
+ * maildir_merge_header - Update a message from a fresh scan of its file
+ * @param ctx Mailbox
+ * @param h   Message in the mailbox
+ * @param n   Header just created from the file's name
+ * @retval true If the message's flags have changed
+ */
+static bool maildir_merge_header(struct Context *ctx, struct Header *h, struct Header *n)
+{
+  bool flags_changed = false;
+
+  /* check to see if the message has moved to a different
+   * subdirectory.  If so, update the associated filename.
+   */
+  if (mutt_str_strcmp(h->path, n->path) != 0)
+    mutt_str_replace(&h->path, n->path);
+
+  /* if the user hasn't modified the flags on this message, update
+   * the flags we just detected.
+   */
+  if (!h->changed)
+    if (maildir_update_flags(ctx, h, n))
+      flags_changed = true;
+
+  if (h->deleted == h->trash)
+    if (h->deleted != n->deleted)
+    {
+      h->deleted = n->deleted;
+      flags_changed = true;
+    }
+  h->trash = n->trash;
+
+  return flags_changed;
+}
+
+/**
+ * maildir_check_delta - Check for new mail by comparing directory listings
+ * @param ctx        Mailbox
+ * @param changed    Subdirectories that have changed, 0x1 = new, 0x2 = cur
+ * @param index_hint Remember our place in the index
+ * @retval >=0 As for maildir_check_mailbox()
+ * @retval  -1 The subdirectories couldn't be listed, do a full scan
+ *
+ * The files in each changed subdirectory are compared with the listing made
+ * by the previous check.  Only the files that have appeared are turned into
+ * headers, so a single new message doesn't cost a rescan of the whole
+ * mailbox.  A flag change, or a move from "new" to "cur", is seen as one
+ * file going and another, with the same canonical name, appearing.
+ *
+ * The messages are only looked at if a file has gone, or if an appearing
+ * file's canonical name is already in the listings.  Then that message is
+ * updated instead of being added again.
+ */
+static int maildir_check_delta(struct Context *ctx, int changed, int *index_hint)
+{
+  static const char *const subdirs[] = { "new", "cur" };
+  struct MhData *data = mh_data(ctx);
+  struct MaildirListing now[2];
+  struct Maildir *md = NULL; /* files that have appeared */
+  struct Maildir **last = &md;
+  struct Maildir *p = NULL;
+  struct Hash *removed = NULL; /* paths of the files that have gone */
+  struct Hash *added = NULL;   /* canonical names of the files that have appeared */
+  char buf[_POSIX_PATH_MAX];
+  bool occult = false;
+  bool flags_changed = false;
+  bool known = false; /* an appearing file may belong to a message we have */
+  int have_new;
+
+  memset(now, 0, sizeof(now));
+  for (int i = 0; i < 2; i++)
+  {
+    if ((changed & (1 << i)) && (maildir_listing_read(ctx, subdirs[i], &now[i]) != 0))
+    {
+      maildir_listing_free(&now[0]);
+      maildir_listing_free(&now[1]);
+      return -1;
+    }
+  }
+
+  for (int i = 0; i < 2; i++)
+  {
+    if (!(changed & (1 << i)))
+      continue;
+
+    struct MaildirListing *old = &data->listing[i];
+    int is_old = option(OPT_MARK_OLD) ? (i == 1) : 0;
+    size_t o = 0, n = 0;
+
+    while ((o < old->count) || (n < now[i].count))
+    {
+      int cmp;
+      if (o == old->count)
+        cmp = 1;
+      else if (n == now[i].count)
+        cmp = -1;
+      else
+        cmp = strcmp(old->names[o], now[i].names[n]);
+
+      if (cmp == 0)
+      {
+        o++;
+        n++;
+      }
+      else if (cmp < 0)
+      {
+        if (!removed)
+          removed = mutt_hash_create(16, MUTT_HASH_STRDUP_KEYS);
+        snprintf(buf, sizeof(buf), "%s/%s", subdirs[i], old->names[o]);
+        mutt_hash_insert(removed, buf, NULL);
+        o++;
+      }
+      else
+      {
+        p = maildir_new_entry(ctx, subdirs[i], now[i].names[n], is_old, 0);
+        maildir_canon_filename(buf, p->h->path, sizeof(buf));
+        p->canon_fname = mutt_str_strdup(buf);
+        if (!known)
+        {
+          known = maildir_listing_has_canon(&data->listing[0], buf) ||
+                  maildir_listing_has_canon(&data->listing[1], buf);
+        }
+        if (!added)
+          added = mutt_hash_create(16, 0);
+        mutt_hash_insert(added, p->canon_fname, p);
+        *last = p;
+        last = &p->next;
+        n++;
+      }
+    }
+
+    maildir_listing_free(old);
+    *old = now[i];
+  }
+
+  /* match the files that have appeared with the messages we know about, as
+   * the full scan does: a file with the name of an existing message, moved
+   * or not, updates that message rather than adding a duplicate */
+  if (removed || known)
+  {
+    for (int i = 0; i < ctx->msgcount; i++)
+    {
+      struct Header *h = ctx->hdrs[i];
+
+      h->active = true;
+      bool gone = removed && mutt_hash_find_elem(removed, h->path);
+      p = NULL;
+      if (added && (known || gone))
+      {
+        maildir_canon_filename(buf, h->path, sizeof(buf));
+        p = mutt_hash_find(added, buf);
+      }
+
+      if (p && p->h)
+      {
+        if (maildir_merge_header(ctx, h, p->h))
+          flags_changed = true;
+        mutt_free_header(&p->h);
+      }
+      else if (gone)
+      {
+        h->active = false;
+        occult = true;
+      }
+    }
+  }
+
+  mutt_hash_destroy(&removed, NULL);
+  mutt_hash_destroy(&added, NULL);
+
+  if (occult)
+    maildir_update_tables(ctx, index_hint);
+
+  maildir_delayed_parsing(ctx, &md, NULL);
+  have_new = maildir_move_to_context(ctx, &md);
+
+  if (occult)
+    return MUTT_REOPENED;
+  if (have_new)
+    return MUTT_NEW_MAIL;
+  if (flags_changed)
+    return MUTT_FLAGS;
+  return 0;
+}
+
 /**
  * maildir_check_mailbox - Check for new mail
  *
@@ -2039,6 +2404,7 @@ static int maildir_check_mailbox(struct Context *ctx, int *index_hint)
   char buf[_POSIX_PATH_MAX];
   int changed = 0;            /* bitmask representing which subdirectories
                                  have changed.  0x1 = new, 0x2 = cur */
+  int scanned = 0;            /* subdirectories that were read completely */
   bool occult = false;        /* messages were removed from the mailbox */
   int have_new = 0;           /* messages were added to the mailbox */
   bool flags_changed = false; /* message flags were changed in the mailbox */
@@ -2076,15 +2442,26 @@ static int maildir_check_mailbox(struct Context *ctx, int *index_hint)
   data->mtime_cur = st_cur.st_mtime;
   ctx->mtime = st_new.st_mtime;
 
+  /* if we know what was there last time, just look at the differences */
+  if ((!(changed & 1) || data->listing[0].valid) && (!(changed & 2) || data->listing[1].valid))
+  {
+    int rc = maildir_check_delta(ctx, changed, index_hint);
+    if (rc >= 0)
+      return rc;
+  }
+
   /* do a fast scan of just the filenames in
    * the subdirectories that have changed.
    */
   md = NULL;
   last = &md;
   if (changed & 1)
-    maildir_parse_dir(ctx, &last, "new", &count, NULL);
+    scanned = (maildir_parse_dir(ctx, &last, "new", &count, NULL) == 0) ? 1 : 0;
   if (changed & 2)
-    maildir_parse_dir(ctx, &last, "cur", &count, NULL);
+    scanned |= (maildir_parse_dir(ctx, &last, "cur", &count, NULL) == 0) ? 2 : 0;
+
+  /* remember what we found, for maildir_check_delta() next time */
+  maildir_listing_store(data, scanned, md);
 
   /* we create a hash table keyed off the canonical (sans flags) filename
    * of each message we scanned.  This is used in the loop over the
@@ -2109,27 +2486,8 @@ static int maildir_check_mailbox(struct Context *ctx, int *index_hint)
     {
       /* message already exists, merge flags */
       ctx->hdrs[i]->active = true;
-
-      /* check to see if the message has moved to a different
-       * subdirectory.  If so, update the associated filename.
-       */
-      if (mutt_str_strcmp(ctx->hdrs[i]->path, p->h->path) != 0)
-        mutt_str_replace(&ctx->hdrs[i]->path, p->h->path);
-
-      /* if the user hasn't modified the flags on this message, update
-       * the flags we just detected.
-       */
-      if (!ctx->hdrs[i]->changed)
-        if (maildir_update_flags(ctx, ctx->hdrs[i], p->h))
-          flags_changed = true;
-
-      if (ctx->hdrs[i]->deleted == ctx->hdrs[i]->trash)
-        if (ctx->hdrs[i]->deleted != p->h->deleted)
-        {
-          ctx->hdrs[i]->deleted = p->h->deleted;
-          flags_changed = true;
-        }
-      ctx->hdrs[i]->trash = p->h->trash;
+      if (maildir_merge_header(ctx, ctx->hdrs[i], p->h))
+        flags_changed = true;
 
       /* this is a duplicate of an existing header, so remove it */
       mutt_free_header(&p->h);
@@ -2316,6 +2674,11 @@ static int mh_sync_mailbox(struct Context *ctx, int *index_hint)
   if (i != 0)
     return i;
 
+  /* we're about to rename and delete files, so the listings
+   * maildir_check_delta() uses are out of date */
+  maildir_listing_free(&mh_data(ctx)->listing[0]);
+  maildir_listing_free(&mh_data(ctx)->listing[1]);
+
 #ifdef USE_HCACHE
   if (ctx->magic == MUTT_MAILDIR || ctx->magic == MUTT_MH)
     hc = mutt_hcache_open(HeaderCache, ctx->path, NULL);
@@ -0,0 +1,401 @@
+/**
+ * @file
+ * Monitor files for changes
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * The mailboxes are watched with inotify(7).  Instead of polling every
+ * mailbox every $mail_check seconds, mutt_buffy_check() only rescans the ones
+ * that have changed.  Waiting for a key is interrupted when a watched mailbox
+ * changes, so that new mail is noticed straight away.
+ *
+ * Mailboxes that can't be watched, e.g. IMAP, are still polled.
+ */
+
+#include "config.h"
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <time.h>
+#include <unistd.h>
+#include "mutt/mutt.h"
+#include "monitor.h"
+#include "buffy.h"
+#include "context.h"
+#include "globals.h"
+#include "mx.h"
+
+bool MonitorFilesChanged = false;
+bool MonitorContextChanged = false;
+
+/**
+ * struct Monitor - A watched file or directory
+ *
+ * inotify returns the same watch descriptor for the same file, so several
+ * Monitors may share one.
+ */
+struct Monitor
+{
+  int wd;              /**< inotify watch descriptor */
+  struct Buffy *buffy; /**< mailbox being watched, NULL for the open mailbox */
+  const char *dir;     /**< maildir subdirectory, "new" or "cur" */
+  struct Monitor *next;
+};
+
+static int INotifyFd = -1;
+static struct Monitor *Monitors = NULL;
+static struct Context *MonitorContext = NULL; /**< open mailbox being watched */
+
+/* what to watch in each kind of mailbox */
+#define MONITOR_FILE_MASK                                                      \
+  (IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF | IN_MASK_ADD)
+#define MONITOR_DIR_MASK                                                       \
+  (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF |      \
+   IN_MOVE_SELF | IN_ONLYDIR | IN_MASK_ADD)
+
+/**
+ * monitor_watch - Watch a file or directory
+ * @param b    Mailbox the path belongs to, NULL for the open mailbox
+ * @param path Path to watch
+ * @param dir  Maildir subdirectory being watched, or NULL
+ * @param mask inotify events to watch for
+ * @retval  0 Success
+ * @retval -1 Error
+ */
+static int monitor_watch(struct Buffy *b, const char *path, const char *dir, uint32_t mask)
+{
+  if (INotifyFd == -1)
+  {
+    INotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (INotifyFd == -1)
+    {
+      mutt_debug(1, "inotify_init1 failed, errno=%d %s\n", errno, strerror(errno));
+      return -1;
+    }
+  }
+
+  int wd = inotify_add_watch(INotifyFd, path, mask);
+  if (wd == -1)
+  {
+    mutt_debug(2, "inotify_add_watch failed for '%s', errno=%d %s\n", path,
+               errno, strerror(errno));
+    return -1;
+  }
+
+  struct Monitor *m = mutt_mem_calloc(1, sizeof(struct Monitor));
+  m->wd = wd;
+  m->buffy = b;
+  m->dir = dir;
+  m->next = Monitors;
+  Monitors = m;
+
+  mutt_debug(3, "watching '%s', wd=%d\n", path, wd);
+  return 0;
+}
+
+/**
+ * monitor_unwatch - Stop watching a mailbox
+ * @param b Mailbox, NULL for the open mailbox
+ * @param rm_watch If true, remove the inotify watches too
+ *
+ * A watch descriptor is only removed once no other mailbox shares it.
+ */
+static void monitor_unwatch(struct Buffy *b, bool rm_watch)
+{
+  struct Monitor **pm = &Monitors;
+
+  while (*pm)
+  {
+    struct Monitor *m = *pm;
+    if (m->buffy != b)
+    {
+      pm = &m->next;
+      continue;
+    }
+
+    *pm = m->next;
+
+    bool shared = false;
+    for (struct Monitor *o = Monitors; o; o = o->next)
+    {
+      if (o->wd == m->wd)
+      {
+        shared = true;
+        break;
+      }
+    }
+    if (rm_watch && !shared)
+      inotify_rm_watch(INotifyFd, m->wd);
+
+    FREE(&m);
+  }
+
+  if (b)
+    b->watched = false;
+  else
+    MonitorContext = NULL;
+}
+
+/**
+ * monitor_add_path - Watch the files of a mailbox
+ * @param b     Mailbox, NULL for the open mailbox
+ * @param path  Path of the mailbox
+ * @param magic Type of the mailbox, e.g. #MUTT_MAILDIR
+ * @retval  0 Success
+ * @retval -1 The mailbox can't be watched
+ */
+static int monitor_add_path(struct Buffy *b, const char *path, int magic)
+{
+  char buf[PATH_MAX];
+
+  switch (magic)
+  {
+    case MUTT_MBOX:
+    case MUTT_MMDF:
+    case MUTT_ZMBOX:
+      /* reading the mailbox changes its "new mail" status */
+      return monitor_watch(b, path, NULL, MONITOR_FILE_MASK | (b ? IN_ACCESS : 0));
+
+    case MUTT_MAILDIR:
+      snprintf(buf, sizeof(buf), "%s/new", path);
+      if (monitor_watch(b, buf, "new", MONITOR_DIR_MASK) != 0)
+        return -1;
+      snprintf(buf, sizeof(buf), "%s/cur", path);
+      return monitor_watch(b, buf, "cur", MONITOR_DIR_MASK);
+
+    case MUTT_MH:
+      /* .mh_sequences is rewritten in place */
+      return monitor_watch(b, path, NULL, MONITOR_DIR_MASK | IN_CLOSE_WRITE);
+
+    default:
+      return -1;
+  }
+}
+
+/**
+ * mutt_monitor_add - Start watching a mailbox
+ * @param b Mailbox, NULL for the open mailbox
+ * @retval  0 The mailbox is being watched
+ * @retval -1 The mailbox can't be watched, so it must be polled
+ */
+int mutt_monitor_add(struct Buffy *b)
+{
+  int rc;
+
+  if (b)
+  {
+    if (b->watched)
+      return 0;
+
+    rc = monitor_add_path(b, b->path, b->magic);
+    if (rc == 0)
+    {
+      b->watched = true;
+      /* anything that happened before now has been missed */
+      b->dirty = true;
+    }
+  }
+  else
+  {
+    if (!Context || !Context->path)
+      return -1;
+    if (MonitorContext == Context)
+      return 0;
+
+    monitor_unwatch(NULL, true);
+    rc = monitor_add_path(NULL, Context->path, Context->magic);
+    if (rc == 0)
+      MonitorContext = Context;
+  }
+
+  if (rc != 0)
+    monitor_unwatch(b, true);
+
+  return rc;
+}
+
+/**
+ * mutt_monitor_remove - Stop watching a mailbox
+ * @param b Mailbox, NULL for the open mailbox
+ */
+void mutt_monitor_remove(struct Buffy *b)
+{
+  monitor_unwatch(b, true);
+}
+
+/**
+ * mutt_monitor_close - A mailbox is being closed
+ * @param ctx Mailbox
+ *
+ * If this is the mailbox being watched, stop watching it.
+ */
+void mutt_monitor_close(struct Context *ctx)
+{
+  if (ctx && (ctx == MonitorContext))
+    monitor_unwatch(NULL, true);
+}
+
+/**
+ * monitor_event - Handle an inotify event
+ * @param wd   Watch descriptor
+ * @param mask Events
+ * @param name Name of the file in a watched directory, or NULL
+ * @retval true If a watched mailbox has changed
+ */
+static bool monitor_event(int wd, uint32_t mask, const char *name)
+{
+  struct Buffy *lost = NULL;
+  bool lost_context = false;
+  bool changed = false;
+
+  for (struct Monitor *m = Monitors; m; m = m->next)
+  {
+    if (m->wd != wd)
+      continue;
+
+    changed = true;
+
+    if (m->buffy)
+    {
+      m->buffy->dirty = true;
+      MonitorFilesChanged = true;
+
+      /* keep the maildir's counts up to date */
+      if (m->dir && name && !(mask & IN_ISDIR))
+      {
+        if (mask & (IN_CREATE | IN_MOVED_TO))
+          mutt_buffy_maildir_event(m->buffy, m->dir, name, true);
+        else if (mask & (IN_DELETE | IN_MOVED_FROM))
+          mutt_buffy_maildir_event(m->buffy, m->dir, name, false);
+      }
+    }
+    else
+      MonitorContextChanged = true;
+
+    /* the file has gone, so has its watch */
+    if (mask & IN_IGNORED)
+    {
+      if (m->buffy)
+        lost = m->buffy;
+      else
+        lost_context = true;
+    }
+  }
+
+  /* keep a mailbox's watches together, it will be watched again once it
+   * has been checked */
+  if (lost)
+    monitor_unwatch(lost, true);
+  if (lost_context)
+    monitor_unwatch(NULL, true);
+
+  return changed;
+}
+
+/**
+ * monitor_read_events - Read all the pending inotify events
+ * @retval true If a watched mailbox has changed
+ */
+static bool monitor_read_events(void)
+{
+  char buf[4096];
+  ssize_t len;
+  bool changed = false;
+
+  while ((len = read(INotifyFd, buf, sizeof(buf))) > 0)
+  {
+    struct inotify_event ev;
+
+    for (char *p = buf; p + sizeof(ev) <= buf + len; p += sizeof(ev) + ev.len)
+    {
+      memcpy(&ev, p, sizeof(ev));
+      mutt_debug(5, "inotify event wd=%d mask=0x%x\n", ev.wd, ev.mask);
+      if (ev.mask & IN_Q_OVERFLOW)
+      {
+        /* events were lost, so rescan everything */
+        for (struct Monitor *m = Monitors; m; m = m->next)
+        {
+          if (m->buffy)
+          {
+            m->buffy->dirty = true;
+            mutt_buffy_maildir_event(m->buffy, NULL, NULL, false);
+          }
+        }
+        MonitorFilesChanged = true;
+        MonitorContextChanged = true;
+        changed = true;
+      }
+      else if (monitor_event(ev.wd, ev.mask, (ev.len > 0) ? p + sizeof(ev) : NULL))
+        changed = true;
+    }
+  }
+
+  return changed;
+}
+
+/**
+ * mutt_monitor_poll - Wait for a key or for a watched mailbox to change
+ * @param timeout Time to wait in milliseconds, as for timeout(3)
+ * @retval  0 A key is waiting, or nothing is being watched
+ * @retval  1 A watched mailbox has changed
+ * @retval -1 Timed out, or interrupted by a signal
+ */
+int mutt_monitor_poll(int timeout)
+{
+  if ((INotifyFd == -1) || !Monitors)
+    return 0;
+
+  struct pollfd fds[2] = {
+    { .fd = 0, .events = POLLIN }, { .fd = INotifyFd, .events = POLLIN },
+  };
+  struct timespec now, end;
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  end.tv_sec += timeout / 1000;
+  end.tv_nsec += (timeout % 1000) * 1000000L;
+
+  while (true)
+  {
+    int rc = poll(fds, 2, timeout);
+    if (rc <= 0)
+      return -1;
+
+    bool changed = false;
+    if (fds[1].revents & POLLIN)
+      changed = monitor_read_events();
+
+    if (fds[0].revents)
+      return 0;
+    if (changed)
+      return 1;
+
+    /* nothing we care about, wait for the rest of the time */
+    if (timeout > 0)
+    {
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      long left = (end.tv_sec - now.tv_sec) * 1000 + (end.tv_nsec - now.tv_nsec) / 1000000L;
+      if (left <= 0)
+        return -1;
+      timeout = (int) left;
+    }
+  }
+}
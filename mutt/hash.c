@@ -25,6 +25,14 @@
  *
  * Hash table data structure.
  *
+ * The table uses open addressing with linear probing.  It starts with room for
+ * the number of elements it's created with and doubles in size whenever it
+ * becomes 70% full, so a small initial size is never a problem.
+ *
+ * Each slot holds the first element with its key, so most elements need no
+ * allocation of their own.  Tables created with #MUTT_HASH_ALLOW_DUPS chain
+ * any further elements with the same key to the slot, newest first.
+ *
  * | Function                | Description
  * | :---------------------- | :---------------------------------------------------------
  * | mutt_hash_create()      | Create a new Hash table (with string keys)
@@ -43,29 +51,68 @@
 
 #include "config.h"
 #include <ctype.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include "hash.h"
 #include "memory.h"
 #include "string2.h"
 
-#define SOMEPRIME 149711
+/**
+ * mix64 - Scramble the bits of a 64-bit number
+ * @param x Number to scramble
+ * @retval num Scrambled number
+ *
+ * This is the finaliser of SplitMix64: every input bit affects every output
+ * bit.
+ */
+static inline uint64_t mix64(uint64_t x)
+{
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+/**
+ * fold_hash - Reduce a 64-bit hash to a non-zero 32-bit one
+ * @param h 64-bit hash
+ * @retval num 32-bit hash, never 0
+ *
+ * A hash of zero marks an empty slot.
+ */
+static inline unsigned int fold_hash(uint64_t h)
+{
+  unsigned int r = (unsigned int) (h ^ (h >> 32));
+  return r ? r : 1;
+}
 
 /**
  * gen_string_hash - Generate a hash from a string
  * @param key String key
- * @param n   Number of elements in the Hash table
- * @retval num Cryptographic hash of the string
+ * @retval num Hash of the string
+ *
+ * The string is consumed eight bytes at a time, mixing each word into the
+ * hash with a multiply and xor-shift, in the manner of wyhash.
  */
-static unsigned int gen_string_hash(union HashKey key, unsigned int n)
+static unsigned int gen_string_hash(union HashKey key)
 {
-  unsigned int h = 0;
-  unsigned char *s = (unsigned char *) key.strkey;
+  const unsigned char *s = (const unsigned char *) key.strkey;
+  size_t len = strlen(key.strkey);
+  uint64_t h = 0x9e3779b97f4a7c15ULL ^ len;
+  uint64_t w;
 
-  while (*s)
-    h += ((h << 7) + *s++);
-  h = (h * SOMEPRIME) % n;
+  for (; len >= 8; s += 8, len -= 8)
+  {
+    memcpy(&w, s, 8);
+    h = mix64(h ^ w);
+  }
 
-  return h;
+  w = 0;
+  memcpy(&w, s, len);
+  return fold_hash(mix64(h ^ w));
 }
 
 /**
@@ -84,19 +131,26 @@ static int cmp_string_key(union HashKey a, union HashKey b)
 /**
  * gen_case_string_hash - Generate a hash from a string (ignore the case)
  * @param key String key
- * @param n   Number of elements in the Hash table
- * @retval num Cryptographic hash of the string
+ * @retval num Hash of the string
  */
-static unsigned int gen_case_string_hash(union HashKey key, unsigned int n)
+static unsigned int gen_case_string_hash(union HashKey key)
 {
-  unsigned int h = 0;
-  unsigned char *s = (unsigned char *) key.strkey;
+  const unsigned char *s = (const unsigned char *) key.strkey;
+  uint64_t h = 0x9e3779b97f4a7c15ULL;
+  unsigned char buf[8];
+  uint64_t w;
 
   while (*s)
-    h += ((h << 7) + tolower(*s++));
-  h = (h * SOMEPRIME) % n;
+  {
+    size_t n = 0;
+    memset(buf, 0, sizeof(buf));
+    while ((n < sizeof(buf)) && *s)
+      buf[n++] = tolower(*s++);
+    memcpy(&w, buf, sizeof(w));
+    h = mix64(h ^ w);
+  }
 
-  return h;
+  return fold_hash(mix64(h));
 }
 
 /**
@@ -115,12 +169,11 @@ static int cmp_case_string_key(union HashKey a, union HashKey b)
 /**
  * gen_int_hash - Generate a hash from an integer
  * @param key Integer key
- * @param n   Number of elements in the Hash table
- * @retval num Cryptographic hash of the integer
+ * @retval num Hash of the integer
  */
-static unsigned int gen_int_hash(union HashKey key, unsigned int n)
+static unsigned int gen_int_hash(union HashKey key)
 {
-  return key.intkey % n;
+  return fold_hash(mix64(key.intkey));
 }
 
 /**
@@ -140,69 +193,167 @@ static int cmp_int_key(union HashKey a, union HashKey b)
   return 1;
 }
 
+/**
+ * alloc_slots - Allocate the slots of a Hash table
+ * @param table Hash table
+ * @param nelem Number of slots, a power of two
+ */
+static void alloc_slots(struct Hash *table, int nelem)
+{
+  table->nelem = nelem;
+  table->table = mutt_mem_calloc(nelem, sizeof(struct HashElem));
+  table->hashes = mutt_mem_calloc(nelem, sizeof(unsigned int));
+}
+
 /**
  * new_hash - Create a new Hash table
  * @param nelem Number of elements it should contain
  * @retval ptr New Hash table
  *
- * The Hash table can contain more elements than nelem, but they will be
- * chained together.
+ * nelem is the expected number of elements, not a number of buckets, so
+ * callers shouldn't add any slack: the table is already sized to be at most
+ * 70% full, and it will grow if more than nelem elements are added.
  */
 static struct Hash *new_hash(int nelem)
 {
   struct Hash *table = mutt_mem_calloc(1, sizeof(struct Hash));
-  if (nelem == 0)
-    nelem = 2;
-  table->nelem = nelem;
-  table->table = mutt_mem_calloc(nelem, sizeof(struct HashElem *));
+  int size = 8;
+
+  /* keep the table no more than 70% full */
+  while ((size < (1 << 30)) && (size * 7 / 10 < nelem))
+    size <<= 1;
+
+  alloc_slots(table, size);
   return table;
 }
 
 /**
- * union_hash_insert - Insert into a hash table using a union as a key
- * @param table     Hash table to update
- * @param key       Key to hash on
- * @param data      Data to associate with `key'
- * @retval -1 on error
- * @retval >=0 on success, index into the hash table
+ * find_slot - Find the slot holding a key
+ * @param table Hash table to search
+ * @param key   Key to look for
+ * @param hash  Hash of the key
+ * @retval num Index of the key's slot, or of the empty slot where it belongs
  */
-static int union_hash_insert(struct Hash *table, union HashKey key, void *data)
+static int find_slot(const struct Hash *table, union HashKey key, unsigned int hash)
+{
+  const unsigned int mask = table->nelem - 1;
+  unsigned int i = hash & mask;
+
+  while (table->hashes[i])
+  {
+    if ((table->hashes[i] == hash) && (table->cmp_key(table->table[i].key, key) == 0))
+      break;
+    i = (i + 1) & mask;
+  }
+
+  return i;
+}
+
+/**
+ * grow_hash - Double the size of a Hash table
+ * @param table Hash table to grow
+ */
+static void grow_hash(struct Hash *table)
 {
-  struct HashElem *ptr = NULL;
-  unsigned int h;
+  struct HashElem *old_table = table->table;
+  unsigned int *old_hashes = table->hashes;
+  int old_nelem = table->nelem;
 
-  ptr = mutt_mem_malloc(sizeof(struct HashElem));
-  h = table->gen_hash(key, table->nelem);
-  ptr->key = key;
-  ptr->data = data;
+  alloc_slots(table, old_nelem * 2);
 
-  if (table->allow_dups)
+  const unsigned int mask = table->nelem - 1;
+  for (int i = 0; i < old_nelem; i++)
   {
-    ptr->next = table->table[h];
-    table->table[h] = ptr;
+    if (!old_hashes[i])
+      continue;
+
+    unsigned int j = old_hashes[i] & mask;
+    while (table->hashes[j])
+      j = (j + 1) & mask;
+    table->hashes[j] = old_hashes[i];
+    table->table[j] = old_table[i];
   }
-  else
+
+  FREE(&old_table);
+  FREE(&old_hashes);
+}
+
+/**
+ * empty_slot - Remove a slot's element, keeping the probe sequences intact
+ * @param table Hash table
+ * @param i     Index of the slot to empty
+ *
+ * Any elements after it, that would be unreachable through the gap, are moved
+ * back.
+ */
+static void empty_slot(struct Hash *table, unsigned int i)
+{
+  const unsigned int mask = table->nelem - 1;
+  unsigned int j = i;
+
+  while (true)
   {
-    struct HashElem *tmp = NULL, *last = NULL;
+    table->hashes[i] = 0;
+    memset(&table->table[i], 0, sizeof(struct HashElem));
 
-    for (tmp = table->table[h], last = NULL; tmp; last = tmp, tmp = tmp->next)
+    while (true)
     {
-      int r = table->cmp_key(tmp->key, key);
-      if (r == 0)
+      j = (j + 1) & mask;
+      if (!table->hashes[j])
       {
-        FREE(&ptr);
-        return -1;
+        table->count--;
+        return;
       }
-      if (r > 0)
+
+      /* can the element at j move back to i? */
+      unsigned int k = table->hashes[j] & mask;
+      if ((i <= j) ? ((k <= i) || (k > j)) : ((k <= i) && (k > j)))
         break;
     }
-    if (last)
-      last->next = ptr;
-    else
-      table->table[h] = ptr;
-    ptr->next = tmp;
+
+    table->hashes[i] = table->hashes[j];
+    table->table[i] = table->table[j];
+    i = j;
   }
-  return h;
+}
+
+/**
+ * union_hash_insert - Insert into a hash table using a union as a key
+ * @param table     Hash table to update
+ * @param key       Key to hash on
+ * @param data      Data to associate with `key'
+ * @retval -1 on error
+ * @retval >=0 on success, index into the hash table
+ */
+static int union_hash_insert(struct Hash *table, union HashKey key, void *data)
+{
+  if ((table->count + 1) > (table->nelem * 7 / 10))
+    grow_hash(table);
+
+  unsigned int hash = table->gen_hash(key);
+  int i = find_slot(table, key, hash);
+  struct HashElem *elem = &table->table[i];
+
+  if (!table->hashes[i])
+  {
+    table->hashes[i] = hash;
+    table->count++;
+    elem->key = key;
+    elem->data = data;
+    elem->next = NULL;
+    return i;
+  }
+
+  if (!table->allow_dups)
+    return -1;
+
+  /* the newest element goes first: move the current one into the chain */
+  struct HashElem *ptr = mutt_mem_malloc(sizeof(struct HashElem));
+  *ptr = *elem;
+  elem->key = key;
+  elem->data = data;
+  elem->next = ptr;
+  return i;
 }
 
 /**
@@ -213,20 +364,13 @@ static int union_hash_insert(struct Hash *table, union HashKey key, void *data)
  */
 static struct HashElem *union_hash_find_elem(const struct Hash *table, union HashKey key)
 {
-  int hash;
-  struct HashElem *ptr = NULL;
-
   if (!table)
     return NULL;
 
-  hash = table->gen_hash(key, table->nelem);
-  ptr = table->table[hash];
-  for (; ptr; ptr = ptr->next)
-  {
-    if (table->cmp_key(key, ptr->key) == 0)
-      return ptr;
-  }
-  return NULL;
+  int i = find_slot(table, key, table->gen_hash(key));
+  if (!table->hashes[i])
+    return NULL;
+  return &table->table[i];
 }
 
 /**
@@ -244,6 +388,21 @@ static void *union_hash_find(const struct Hash *table, union HashKey key)
     return NULL;
 }
 
+/**
+ * free_elem_data - Free the data and key of a HashElem
+ * @param table   Hash table
+ * @param elem    HashElem
+ * @param destroy Callback function to free the HashElem's data
+ */
+static void free_elem_data(struct Hash *table, struct HashElem *elem,
+                           void (*destroy)(void *))
+{
+  if (destroy)
+    destroy(elem->data);
+  if (table->strdup_keys)
+    FREE(&elem->key.strkey);
+}
+
 /**
  * union_hash_delete - Remove an element from a Hash table
  * @param table   Hash table to use
@@ -254,35 +413,43 @@ static void *union_hash_find(const struct Hash *table, union HashKey key)
 static void union_hash_delete(struct Hash *table, union HashKey key,
                               const void *data, void (*destroy)(void *))
 {
-  int hash;
-  struct HashElem *ptr = NULL, **last = NULL;
-
   if (!table)
     return;
 
-  hash = table->gen_hash(key, table->nelem);
-  ptr = table->table[hash];
-  last = &table->table[hash];
+  int i = find_slot(table, key, table->gen_hash(key));
+  if (!table->hashes[i])
+    return;
+
+  struct HashElem *head = &table->table[i];
 
-  while (ptr)
+  /* the chained duplicates first */
+  struct HashElem **last = &head->next;
+  while (*last)
   {
-    if (((data == ptr->data) || !data) && table->cmp_key(ptr->key, key) == 0)
+    struct HashElem *ptr = *last;
+    if ((data == ptr->data) || !data)
     {
       *last = ptr->next;
-      if (destroy)
-        destroy(ptr->data);
-      if (table->strdup_keys)
-        FREE(&ptr->key.strkey);
+      free_elem_data(table, ptr, destroy);
       FREE(&ptr);
-
-      ptr = *last;
     }
     else
-    {
       last = &ptr->next;
-      ptr = ptr->next;
-    }
   }
+
+  if ((data != head->data) && data)
+    return;
+
+  free_elem_data(table, head, destroy);
+  if (head->next)
+  {
+    /* promote the next duplicate into the slot */
+    struct HashElem *ptr = head->next;
+    *head = *ptr;
+    FREE(&ptr);
+  }
+  else
+    empty_slot(table, i);
 }
 
 /**
@@ -339,7 +506,10 @@ int mutt_hash_insert(struct Hash *table, const char *strkey, void *data)
 {
   union HashKey key;
   key.strkey = table->strdup_keys ? mutt_str_strdup(strkey) : strkey;
-  return union_hash_insert(table, key, data);
+  int rc = union_hash_insert(table, key, data);
+  if ((rc < 0) && table->strdup_keys)
+    FREE(&key.strkey);
+  return rc;
 }
 
 /**
@@ -403,18 +573,13 @@ void *mutt_hash_int_find(const struct Hash *table, unsigned int intkey)
  * @retval ptr HashElem matching the key
  *
  * Unlike mutt_hash_find_elem(), this will return the first matching entry.
+ * Any other entries with the same key follow it, through HashElem.next.
  */
 struct HashElem *mutt_hash_find_bucket(const struct Hash *table, const char *strkey)
 {
   union HashKey key;
-  int hash;
-
-  if (!table)
-    return NULL;
-
   key.strkey = strkey;
-  hash = table->gen_hash(key, table->nelem);
-  return table->table[hash];
+  return union_hash_find_elem(table, key);
 }
 
 /**
@@ -463,18 +628,20 @@ void mutt_hash_destroy(struct Hash **ptr, void (*destroy)(void *))
   pptr = *ptr;
   for (int i = 0; i < pptr->nelem; i++)
   {
-    for (elem = pptr->table[i]; elem;)
+    if (!pptr->hashes[i])
+      continue;
+
+    free_elem_data(pptr, &pptr->table[i], destroy);
+    for (elem = pptr->table[i].next; elem;)
     {
       tmp = elem;
       elem = elem->next;
-      if (destroy)
-        destroy(tmp->data);
-      if (pptr->strdup_keys)
-        FREE(&tmp->key.strkey);
+      free_elem_data(pptr, tmp, destroy);
       FREE(&tmp);
     }
   }
   FREE(&pptr->table);
+  FREE(&pptr->hashes);
   FREE(ptr);
 }
 
@@ -498,9 +665,9 @@ struct HashElem *mutt_hash_walk(const struct Hash *table, struct HashWalkState *
 
   while (state->index < table->nelem)
   {
-    if (table->table[state->index])
+    if (table->hashes[state->index])
     {
-      state->last = table->table[state->index];
+      state->last = &table->table[state->index];
       return state->last;
     }
     state->index++;
@@ -45,14 +45,19 @@ struct HashElem
 
 /**
  * struct Hash - A Hash Table
+ *
+ * The table uses open addressing: each slot holds the first element with its
+ * key.  Elements with duplicate keys are chained to it.
  */
 struct Hash
 {
-  int nelem;
-  bool strdup_keys : 1; /**< if set, the key->strkey is strdup'ed */
-  bool allow_dups  : 1; /**< if set, duplicate keys are allowed */
-  struct HashElem **table;
-  unsigned int (*gen_hash)(union HashKey, unsigned int);
+  int nelem;                /**< Number of slots, a power of two */
+  int count;                /**< Number of slots in use */
+  bool strdup_keys : 1;     /**< if set, the key->strkey is strdup'ed */
+  bool allow_dups  : 1;     /**< if set, duplicate keys are allowed */
+  struct HashElem *table;   /**< Slots */
+  unsigned int *hashes;     /**< Hash of each slot's key, 0 if the slot is empty */
+  unsigned int (*gen_hash)(union HashKey);
   int (*cmp_key)(union HashKey, union HashKey);
 };
 
@@ -0,0 +1,148 @@
+/**
+ * @file
+ * Shared copies of common strings
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page intern Shared copies of common strings
+ *
+ * Strings that repeat across many emails, e.g. the names and addresses of the
+ * people on a mailing list, are stored once and reference counted.  Equal
+ * interned strings have the same address.
+ *
+ * An interned string must never be modified or passed to free().  It is
+ * released with mutt_intern_release(), which also accepts ordinary malloc'd
+ * strings, so a field may safely hold either kind.
+ *
+ * | Function              | Description
+ * | :-------------------- | :-----------------------------------------------
+ * | mutt_intern_add()     | Get a shared copy of a string
+ * | mutt_intern_release() | Release a string that may be shared
+ * | mutt_intern_take()    | Replace a malloc'd string with a shared copy
+ */
+
+#include "config.h"
+#include <stddef.h>
+#include <string.h>
+#include "intern.h"
+#include "hash.h"
+#include "memory.h"
+#include "string2.h"
+
+/**
+ * struct InternString - A shared string
+ */
+struct InternString
+{
+  size_t refs; /**< Number of users of the string */
+  char str[];  /**< The string itself */
+};
+
+/* initial size, the table grows as needed */
+#define INTERN_TABLE_SIZE 1024
+
+static struct Hash *InternTable = NULL;
+
+/**
+ * find_interned - Find the shared copy of a string
+ * @param str String to look for
+ * @retval ptr  The InternString holding str
+ * @retval NULL str is not a shared string
+ *
+ * A match means that str is the very same pointer, not just an equal string.
+ */
+static struct InternString *find_interned(const char *str)
+{
+  if (!InternTable || !str)
+    return NULL;
+
+  struct InternString *is = mutt_hash_find(InternTable, str);
+  if (is && (is->str == str))
+    return is;
+  return NULL;
+}
+
+/**
+ * mutt_intern_add - Get a shared copy of a string
+ * @param str String to copy
+ * @retval ptr  Shared string, release with mutt_intern_release()
+ * @retval NULL str was NULL
+ */
+char *mutt_intern_add(const char *str)
+{
+  if (!str)
+    return NULL;
+
+  if (!InternTable)
+    InternTable = mutt_hash_create(INTERN_TABLE_SIZE, 0);
+
+  struct InternString *is = mutt_hash_find(InternTable, str);
+  if (!is)
+  {
+    size_t len = strlen(str) + 1;
+    is = mutt_mem_malloc(sizeof(struct InternString) + len);
+    is->refs = 0;
+    memcpy(is->str, str, len);
+    mutt_hash_insert(InternTable, is->str, is);
+  }
+
+  is->refs++;
+  return is->str;
+}
+
+/**
+ * mutt_intern_release - Release a string that may be shared
+ * @param ptr String to release
+ *
+ * Shared strings lose a reference; any other string is freed.
+ * The pointer is set to NULL.
+ */
+void mutt_intern_release(char **ptr)
+{
+  if (!ptr || !*ptr)
+    return;
+
+  struct InternString *is = find_interned(*ptr);
+  if (!is)
+  {
+    FREE(ptr);
+    return;
+  }
+
+  *ptr = NULL;
+  if (--is->refs > 0)
+    return;
+
+  mutt_hash_delete(InternTable, is->str, is, NULL);
+  FREE(&is);
+}
+
+/**
+ * mutt_intern_take - Replace a malloc'd string with a shared copy
+ * @param ptr String to replace
+ *
+ * The original string is freed.
+ */
+void mutt_intern_take(char **ptr)
+{
+  if (!ptr || !*ptr || find_interned(*ptr))
+    return;
+
+  char *shared = mutt_intern_add(*ptr);
+  FREE(ptr);
+  *ptr = shared;
+}
@@ -35,12 +35,14 @@
  * -# @subpage exit
  * -# @subpage file
  * -# @subpage hash
+ * -# @subpage intern
  * -# @subpage list
  * -# @subpage mapping
  * -# @subpage mbyte
  * -# @subpage md5
  * -# @subpage memory
  * -# @subpage message
+ * -# @subpage pool
  * -# @subpage sha1
  * -# @subpage string
  */
@@ -55,12 +57,14 @@
 #include "exit.h"
 #include "file.h"
 #include "hash.h"
+#include "intern.h"
 #include "list.h"
 #include "mapping.h"
 #include "mbyte.h"
 #include "md5.h"
 #include "memory.h"
 #include "message.h"
+#include "pool.h"
 #include "sha1.h"
 #include "string2.h"
 
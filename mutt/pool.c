@@ -0,0 +1,144 @@
+/**
+ * @file
+ * Pool of fixed-size objects
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page pool Pool of fixed-size objects
+ *
+ * Objects of a single type are carved out of large chunks of memory, rather
+ * than being allocated one at a time.  They sit next to each other in memory
+ * and the whole pool can be released at once.  Objects can also be released
+ * singly; they are kept for reuse by the next mutt_pool_alloc().
+ *
+ * | Function            | Description
+ * | :------------------ | :-----------------------------------------
+ * | mutt_pool_alloc()   | Allocate a zeroed object from a Pool
+ * | mutt_pool_create()  | Create a new Pool
+ * | mutt_pool_destroy() | Release a Pool and all of its objects
+ * | mutt_pool_free()    | Return an object to a Pool
+ */
+
+#include "config.h"
+#include <string.h>
+#include "pool.h"
+#include "memory.h"
+
+/**
+ * struct PoolChunk - A block of memory holding many objects
+ *
+ * The objects follow the header, which is padded to keep them aligned.
+ */
+struct PoolChunk
+{
+  union {
+    struct PoolChunk *next; /**< Next (older) chunk */
+    long double align;      /**< Alignment for the objects */
+  } u;
+};
+
+/**
+ * mutt_pool_create - Create a new Pool
+ * @param size      Size of each object
+ * @param per_chunk Number of objects to allocate at a time
+ * @retval ptr New Pool
+ *
+ * The caller should call mutt_pool_destroy() to release the Pool.
+ */
+struct Pool *mutt_pool_create(size_t size, size_t per_chunk)
+{
+  struct Pool *pool = mutt_mem_calloc(1, sizeof(struct Pool));
+  const size_t align = sizeof(struct PoolChunk);
+
+  /* freed objects hold a pointer to the next free object */
+  if (size < sizeof(void *))
+    size = sizeof(void *);
+  pool->size = (size + align - 1) / align * align;
+  pool->per_chunk = per_chunk ? per_chunk : 1;
+  pool->used = pool->per_chunk;
+  return pool;
+}
+
+/**
+ * mutt_pool_destroy - Release a Pool and all of its objects
+ * @param ptr Pool to release
+ */
+void mutt_pool_destroy(struct Pool **ptr)
+{
+  if (!ptr || !*ptr)
+    return;
+
+  struct PoolChunk *chunk = (*ptr)->chunks;
+  while (chunk)
+  {
+    struct PoolChunk *next = chunk->u.next;
+    FREE(&chunk);
+    chunk = next;
+  }
+  FREE(ptr);
+}
+
+/**
+ * mutt_pool_alloc - Allocate a zeroed object from a Pool
+ * @param pool Pool to use
+ * @retval ptr New object
+ *
+ * @note This function will never return NULL.
+ */
+void *mutt_pool_alloc(struct Pool *pool)
+{
+  void *obj = NULL;
+
+  if (pool->free_list)
+  {
+    obj = pool->free_list;
+    pool->free_list = *(void **) obj;
+  }
+  else
+  {
+    if (pool->used == pool->per_chunk)
+    {
+      struct PoolChunk *chunk =
+          mutt_mem_malloc(sizeof(struct PoolChunk) + pool->size * pool->per_chunk);
+      chunk->u.next = pool->chunks;
+      pool->chunks = chunk;
+      pool->used = 0;
+    }
+    obj = (char *) (pool->chunks + 1) + pool->size * pool->used++;
+  }
+
+  pool->count++;
+  memset(obj, 0, pool->size);
+  return obj;
+}
+
+/**
+ * mutt_pool_free - Return an object to a Pool
+ * @param pool Pool the object came from
+ * @param obj  Object to release
+ *
+ * The memory isn't returned to the system until mutt_pool_destroy().
+ */
+void mutt_pool_free(struct Pool *pool, void *obj)
+{
+  if (!pool || !obj)
+    return;
+
+  *(void **) obj = pool->free_list;
+  pool->free_list = obj;
+  pool->count--;
+}
@@ -0,0 +1,45 @@
+/**
+ * @file
+ * Pool of fixed-size objects
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MUTT_POOL_H
+#define _MUTT_POOL_H
+
+#include <stddef.h>
+
+struct PoolChunk;
+
+/**
+ * struct Pool - A pool of fixed-size objects
+ */
+struct Pool
+{
+  size_t size;              /**< Size of each object */
+  size_t per_chunk;         /**< Number of objects in each chunk */
+  size_t used;              /**< Objects handed out from the newest chunk */
+  size_t count;             /**< Number of objects currently allocated */
+  struct PoolChunk *chunks; /**< List of chunks, newest first */
+  void *free_list;          /**< Released objects, ready for reuse */
+};
+
+struct Pool *mutt_pool_create(size_t size, size_t per_chunk);
+void         mutt_pool_destroy(struct Pool **ptr);
+void *       mutt_pool_alloc(struct Pool *pool);
+void         mutt_pool_free(struct Pool *pool, void *obj);
+
+#endif /* _MUTT_POOL_H */
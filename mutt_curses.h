@@ -113,6 +113,8 @@ struct Event
 };
 
 struct Event mutt_getch(void);
+void mutt_getch_timeout(int delay);
+bool mutt_input_pending(void);
 
 void mutt_endwin(const char *msg);
 void mutt_flushinp(void);
@@ -192,6 +194,7 @@ struct ColorLine
   regex_t regex;
   int match; /**< which substringmap 0 for old behaviour */
   char *pattern;
+  bool anchored; /**< pattern depends on where the search starts, e.g. ^ or \< */
   struct Pattern *color_pattern; /**< compiled pattern to speed up index color
                                       calculation */
   short fg;
@@ -81,7 +81,7 @@ static int addr_is_intl(struct Address *a)
 
 static void set_local_mailbox(struct Address *a, char *local_mailbox)
 {
-  FREE(&a->mailbox);
+  mutt_intern_release(&a->mailbox);
   a->mailbox = local_mailbox;
   a->intl_checked = true;
   a->is_intl = false;
@@ -89,7 +89,7 @@ static void set_local_mailbox(struct Address *a, char *local_mailbox)
 
 static void set_intl_mailbox(struct Address *a, char *intl_mailbox)
 {
-  FREE(&a->mailbox);
+  mutt_intern_release(&a->mailbox);
   a->mailbox = intl_mailbox;
   a->intl_checked = true;
   a->is_intl = true;
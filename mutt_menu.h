@@ -97,9 +97,14 @@ struct Menu
   int oldcurrent; /**< for driver use only. */
   int search_dir;  /**< direction of search */
   int tagged;     /**< number of tagged entries */
+
+  struct MenuRow *rows;  /**< what menu_redraw_index() last drew */
+  int rows_len;          /**< number of entries in rows */
+  unsigned int rows_gen; /**< screen generation the rows belong to */
 };
 
 void mutt_menu_init(void);
+void mutt_menu_forget_rows(void);
 void menu_redraw_full(struct Menu *menu);
 #ifdef USE_SIDEBAR
 void menu_redraw_sidebar(struct Menu *menu);
@@ -1797,6 +1797,7 @@ static int nm_commit_message_tags(struct Context *ctx, struct Header *hdr, char
   update_header_flags(ctx, hdr, buf);
   update_header_tags(hdr, msg);
   mutt_set_header_color(ctx, hdr);
+  mutt_index_line_invalidate(hdr);
 
   rc = 0;
   hdr->changed = true;
@@ -68,9 +68,15 @@
 #ifdef USE_NNTP
 #include "nntp.h"
 #endif
+#ifdef USE_ZLIB
+#include "zmbox.h"
+#endif
 #ifdef USE_NOTMUCH
 #include "mutt_notmuch.h"
 #endif
+#ifdef USE_INOTIFY
+#include "monitor.h"
+#endif
 
 struct MxOps *mx_get_ops(int magic)
 {
@@ -103,6 +109,10 @@ struct MxOps *mx_get_ops(int magic)
 #ifdef USE_NOTMUCH
     case MUTT_NOTMUCH:
       return &mx_notmuch_ops;
+#endif
+#ifdef USE_ZLIB
+    case MUTT_ZMBOX:
+      return &mx_zmbox_ops;
 #endif
     default:
       return NULL;
@@ -257,7 +267,7 @@ int mx_get_magic(const char *path)
   else if (st.st_size == 0)
   {
     /* hard to tell what zero-length files are, so assume the default magic */
-    if (MboxType == MUTT_MBOX || MboxType == MUTT_MMDF)
+    if (MboxType == MUTT_MBOX || MboxType == MUTT_MMDF || MboxType == MUTT_ZMBOX)
       return MboxType;
     else
       return MUTT_MBOX;
@@ -286,6 +296,10 @@ int mx_get_magic(const char *path)
       else if (mutt_str_strcmp(MMDF_SEP, tmp) == 0)
         magic = MUTT_MMDF;
     }
+#ifdef USE_ZLIB
+    if ((magic == 0) && zmbox_is_archive(f))
+      magic = MUTT_ZMBOX;
+#endif
     mutt_file_fclose(&f);
 
     if (!option(OPT_CHECK_MBOX_SIZE))
@@ -327,6 +341,10 @@ int mx_set_magic(const char *s)
     MboxType = MUTT_MH;
   else if (mutt_str_strcasecmp(s, "maildir") == 0)
     MboxType = MUTT_MAILDIR;
+#ifdef USE_ZLIB
+  else if (mutt_str_strcasecmp(s, "zmbox") == 0)
+    MboxType = MUTT_ZMBOX;
+#endif
   else
     return -1;
 
@@ -430,6 +448,7 @@ struct Context *mx_open_mailbox(const char *path, int flags, struct Context *pct
 
   ctx->msgnotreadyet = -1;
   ctx->collapsed = false;
+  ctx->hdr_pool = mutt_header_pool_new();
 
   for (rc = 0; rc < RIGHTSMAX; rc++)
     mutt_bit_set(ctx->rights, rc);
@@ -532,6 +551,10 @@ void mx_fastclose_mailbox(struct Context *ctx)
   if (!ctx->peekonly)
     mutt_buffy_setnotified(ctx->path);
 
+#ifdef USE_INOTIFY
+  mutt_monitor_close(ctx);
+#endif
+
   if (ctx->mx_ops)
     ctx->mx_ops->close(ctx);
 
@@ -543,6 +566,7 @@ void mx_fastclose_mailbox(struct Context *ctx)
   mutt_clear_threads(ctx);
   for (int i = 0; i < ctx->msgcount; i++)
     mutt_free_header(&ctx->hdrs[i]);
+  mutt_header_pool_free(&ctx->hdr_pool);
   FREE(&ctx->hdrs);
   FREE(&ctx->v2r);
   FREE(&ctx->path);
@@ -811,7 +835,7 @@ int mx_close_mailbox(struct Context *ctx, int *index_hint)
   {
     if (!ctx->quiet)
       mutt_message(_("Mailbox is unchanged."));
-    if (ctx->magic == MUTT_MBOX || ctx->magic == MUTT_MMDF)
+    if (ctx->magic == MUTT_MBOX || ctx->magic == MUTT_MMDF || ctx->magic == MUTT_ZMBOX)
       mbox_reset_atime(ctx, NULL);
     mx_fastclose_mailbox(ctx);
     return 0;
@@ -871,7 +895,8 @@ int mx_close_mailbox(struct Context *ctx, int *index_hint)
       mutt_message(_("%d kept, %d deleted."), ctx->msgcount - ctx->deleted, ctx->deleted);
   }
 
-  if (ctx->msgcount == ctx->deleted && (ctx->magic == MUTT_MMDF || ctx->magic == MUTT_MBOX) &&
+  if (ctx->msgcount == ctx->deleted &&
+      (ctx->magic == MUTT_MMDF || ctx->magic == MUTT_MBOX || ctx->magic == MUTT_ZMBOX) &&
       !mutt_is_spool(ctx->path) && !option(OPT_SAVE_EMPTY))
     mutt_file_unlink_empty(ctx->path);
 
@@ -1084,7 +1109,8 @@ int mx_sync_mailbox(struct Context *ctx, int *index_hint)
 
     mutt_sleep(0);
 
-    if (ctx->msgcount == ctx->deleted && (ctx->magic == MUTT_MBOX || ctx->magic == MUTT_MMDF) &&
+    if (ctx->msgcount == ctx->deleted &&
+        (ctx->magic == MUTT_MBOX || ctx->magic == MUTT_MMDF || ctx->magic == MUTT_ZMBOX) &&
         !mutt_is_spool(ctx->path) && !option(OPT_SAVE_EMPTY))
     {
       unlink(ctx->path);
@@ -1155,7 +1181,8 @@ struct Message *mx_open_new_message(struct Context *dest, struct Header *hdr, in
     if (dest->magic == MUTT_MMDF)
       fputs(MMDF_SEP, msg->fp);
 
-    if ((dest->magic == MUTT_MBOX || dest->magic == MUTT_MMDF) && flags & MUTT_ADD_FROM)
+    if ((dest->magic == MUTT_MBOX || dest->magic == MUTT_MMDF || dest->magic == MUTT_ZMBOX) &&
+        flags & MUTT_ADD_FROM)
     {
       if (hdr)
       {
@@ -1364,6 +1391,7 @@ int mx_check_empty(const char *path)
   {
     case MUTT_MBOX:
     case MUTT_MMDF:
+    case MUTT_ZMBOX:
       return mutt_file_check_empty(path);
     case MUTT_MH:
       return mh_check_empty(path);
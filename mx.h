@@ -81,6 +81,7 @@ enum MailboxFormat
   MUTT_NOTMUCH,
   MUTT_POP,
   MUTT_COMPRESSED,
+  MUTT_ZMBOX,
 };
 
 WHERE short MboxType;
@@ -88,6 +89,8 @@ WHERE short MboxType;
 #define MMDF_SEP "\001\001\001\001\n"
 
 void mbox_reset_atime(struct Context *ctx, struct stat *st);
+int mbox_open_stream(struct Context *ctx, FILE *fp, LOFF_T size);
+int mbox_reopen_mailbox(struct Context *ctx, int *index_hint);
 
 int mh_check_empty(const char *path);
 
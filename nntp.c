@@ -1125,7 +1125,7 @@ static int parse_overview_line(char *line, void *data)
     mx_alloc_memory(ctx);
 
   /* parse header */
-  hdr = ctx->hdrs[ctx->msgcount] = mutt_new_header();
+  hdr = ctx->hdrs[ctx->msgcount] = mutt_new_pooled_header(ctx->hdr_pool);
   hdr->env = mutt_read_rfc822_header(fp, hdr, 0, 0);
   hdr->env->newsgroups = mutt_str_strdup(nntp_data->group);
   hdr->received = hdr->date_sent;
@@ -1381,7 +1381,7 @@ static int nntp_fetch_headers(struct Context *ctx, void *hc, anum_t first,
       }
 
       /* parse header */
-      hdr = ctx->hdrs[ctx->msgcount] = mutt_new_header();
+      hdr = ctx->hdrs[ctx->msgcount] = mutt_new_pooled_header(ctx->hdr_pool);
       hdr->env = mutt_read_rfc822_header(fp, hdr, 0, 0);
       hdr->received = hdr->date_sent;
       mutt_file_fclose(&fp);
@@ -1658,7 +1658,10 @@ static int nntp_open_message(struct Context *ctx, struct Message *msg, int msgno
     }
 
     if (!acache->path)
+    {
+      fflush(msg->fp);
       mutt_bcache_commit(nntp_data->bcache, article);
+    }
   }
 
   /* replace envelope with new one
@@ -2392,7 +2395,7 @@ int nntp_check_msgid(struct Context *ctx, const char *msgid)
   /* parse header */
   if (ctx->msgcount == ctx->hdrmax)
     mx_alloc_memory(ctx);
-  hdr = ctx->hdrs[ctx->msgcount] = mutt_new_header();
+  hdr = ctx->hdrs[ctx->msgcount] = mutt_new_pooled_header(ctx->hdr_pool);
   hdr->data = mutt_mem_calloc(1, sizeof(struct NntpHeaderData));
   hdr->env = mutt_read_rfc822_header(fp, hdr, 0, 0);
   mutt_file_fclose(&fp);
@@ -89,6 +89,7 @@ enum GlobalBool
   OPT_IMAP_CHECK_SUBSCRIBED,
   OPT_IMAP_IDLE,
   OPT_IMAP_LIST_SUBSCRIBED,
+  OPT_IMAP_NOTIFY,
   OPT_IMAP_PASSIVE,
   OPT_IMAP_PEEK,
   OPT_IMAP_SERVERNOISE,
@@ -112,6 +113,7 @@ enum GlobalBool
   OPT_IMPLICIT_AUTOVIEW,
   OPT_INCLUDE_ONLYFIRST,
   OPT_KEEP_FLAGGED,
+  OPT_LIMIT_REFRESH,
   OPT_MAILCAP_SANITIZE,
   OPT_MAIL_CHECK_RECENT,
   OPT_MAIL_CHECK_STATS,
@@ -123,6 +125,10 @@ enum GlobalBool
   OPT_MENU_MOVE_OFF, /**< allow menu to scroll past last entry */
 #if defined(USE_IMAP) || defined(USE_POP)
   OPT_MESSAGE_CACHE_CLEAN,
+#endif
+#if defined(USE_IMAP) || defined(USE_POP) || defined(USE_NNTP)
+  OPT_MESSAGE_CACHE_DEDUP,  /**< share identical bodies in the message cache */
+  OPT_MESSAGE_CACHE_PACKED, /**< store each mailbox's cached bodies in one file */
 #endif
   OPT_META_KEY, /**< interpret ALT-x as ESC-x */
   OPT_METOO,
@@ -255,6 +261,7 @@ enum GlobalBool
   OPT_RESORT_INIT,        /**< (pseudo) used to force the next resort to be from scratch */
   OPT_VIEW_ATTACH,        /**< (pseudo) signals that we are viewing attachments */
   OPT_SORT_SUBTHREADS,    /**< (pseudo) used when $sort_aux changes */
+  OPT_SORT_NEW_MAIL,      /**< (pseudo) only newly arrived messages need threading */
   OPT_NEED_RESCORE,       /**< (pseudo) set when the `score' command is used */
   OPT_ATTACH_MSG,         /**< (pseudo) used by attach-message */
   OPT_HIDE_READ,          /**< (pseudo) whether or not hide read messages */
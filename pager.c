@@ -65,6 +65,9 @@
 #ifdef USE_NNTP
 #include "nntp.h"
 #endif
+#ifdef USE_INOTIFY
+#include "monitor.h"
+#endif
 
 #define ISHEADER(x) ((x) == MT_COLOR_HEADER || (x) == MT_COLOR_HDEFAULT)
 
@@ -152,6 +155,7 @@ struct Line
   struct Syntax *search;
   struct QClass *quote;
   unsigned int is_cont_hdr; /**< this line is a continuation of the previous header line */
+  bool colors_pending : 1;  /**< body colours haven't been matched yet */
 };
 
 #define ANSI_OFF (1 << 0)
@@ -753,6 +757,131 @@ static int check_attachment_marker(char *p)
   return (int) (*p - *q);
 }
 
+/**
+ * resolve_body_colors - Match the body colour patterns against a line
+ * @param buf       Line text, without the bold and underline controls
+ * @param line_info Lines of the pager
+ * @param n         Line to colour
+ *
+ * resolve_types() leaves this until the line is about to be drawn, so that
+ * laying out a long message doesn't run every regex against every line.
+ *
+ * The next match of every pattern is remembered, so each pattern is only run
+ * again once the scan has moved past its match, rather than once per chunk.
+ * Patterns with ^ or word boundaries are still run for every chunk, because
+ * their matches depend on where the search starts.
+ */
+static void resolve_body_colors(char *buf, struct Line *line_info, int n)
+{
+  struct ColorLine *color_line = NULL;
+  regmatch_t pmatch[1];
+  regmatch_t *next = NULL;
+  bool found;
+  bool null_rx;
+  int offset, i, r;
+
+  line_info[n].colors_pending = false;
+
+  if (line_info[n].type == MT_COLOR_NORMAL || line_info[n].type == MT_COLOR_QUOTED ||
+      (line_info[n].type == MT_COLOR_HDEFAULT && option(OPT_HEADER_COLOR_PARTIAL)))
+  {
+    size_t nl;
+
+    /* don't consider line endings part of the buffer
+     * for regex matching */
+    if ((nl = mutt_str_strlen(buf)) > 0 && buf[nl - 1] == '\n')
+      buf[nl - 1] = 0;
+
+    struct ColorLineHead *head = NULL;
+    if (line_info[n].type == MT_COLOR_HDEFAULT)
+      head = &ColorHdrList;
+    else
+      head = &ColorBodyList;
+
+    /* rm_so is -2 if the pattern hasn't been run, -1 if it doesn't match */
+    r = 0;
+    STAILQ_FOREACH(color_line, head, entries)
+    {
+      r++;
+    }
+    next = mutt_mem_malloc(MAX(r, 1) * sizeof(regmatch_t));
+    for (int j = 0; j < r; j++)
+      next[j].rm_so = -2;
+
+    i = 0;
+    offset = 0;
+    line_info[n].chunks = 0;
+    do
+    {
+      if (!buf[offset])
+        break;
+
+      found = false;
+      null_rx = false;
+      r = 0;
+      STAILQ_FOREACH(color_line, head, entries)
+      {
+        regmatch_t *m = &next[r++];
+
+        /* a match behind the scan may overlap a match starting at offset,
+         * and an anchored pattern may match differently from a new offset */
+        if (color_line->anchored || (m->rm_so == -2) || ((m->rm_so >= 0) && (m->rm_so < offset)))
+        {
+          if (regexec(&color_line->regex, buf + offset, 1, m, (offset ? REG_NOTBOL : 0)) == 0)
+          {
+            m->rm_so += offset;
+            m->rm_eo += offset;
+          }
+          else
+            m->rm_so = -1;
+        }
+
+        if (m->rm_so >= 0)
+        {
+          pmatch[0] = *m;
+          if (pmatch[0].rm_eo != pmatch[0].rm_so)
+          {
+            if (!found)
+            {
+              /* Abort if we fill up chunks.
+               * Yes, this really happened. See #3888 */
+              if (line_info[n].chunks == SHRT_MAX)
+              {
+                null_rx = false;
+                break;
+              }
+              if (++(line_info[n].chunks) > 1)
+                mutt_mem_realloc(&(line_info[n].syntax),
+                                 (line_info[n].chunks) * sizeof(struct Syntax));
+            }
+            i = line_info[n].chunks - 1;
+            if (!found || pmatch[0].rm_so < (line_info[n].syntax)[i].first ||
+                (pmatch[0].rm_so == (line_info[n].syntax)[i].first &&
+                 pmatch[0].rm_eo > (line_info[n].syntax)[i].last))
+            {
+              (line_info[n].syntax)[i].color = color_line->pair;
+              (line_info[n].syntax)[i].first = pmatch[0].rm_so;
+              (line_info[n].syntax)[i].last = pmatch[0].rm_eo;
+            }
+            found = true;
+            null_rx = false;
+          }
+          else
+            null_rx = true; /* empty regex; don't add it, but keep looking */
+        }
+      }
+
+      if (null_rx)
+        offset++; /* avoid degenerate cases */
+      else
+        offset = (line_info[n].syntax)[i].last;
+    } while (found || null_rx);
+    if (nl > 0)
+      buf[nl] = '\n';
+    FREE(&next);
+  }
+}
+
 static void resolve_types(char *buf, char *raw, struct Line *line_info, int n,
                           int last, struct QClass **quote_list, int *q_level,
                           int *force_redraw, int q_classify)
@@ -887,78 +1016,12 @@ static void resolve_types(char *buf, char *raw, struct Line *line_info, int n,
   else
     line_info[n].type = MT_COLOR_NORMAL;
 
-  /* body patterns */
+  /* body patterns are only needed to draw the line, see display_line() */
   if (line_info[n].type == MT_COLOR_NORMAL || line_info[n].type == MT_COLOR_QUOTED ||
       (line_info[n].type == MT_COLOR_HDEFAULT && option(OPT_HEADER_COLOR_PARTIAL)))
   {
-    size_t nl;
-
-    /* don't consider line endings part of the buffer
-     * for regex matching */
-    if ((nl = mutt_str_strlen(buf)) > 0 && buf[nl - 1] == '\n')
-      buf[nl - 1] = 0;
-
-    i = 0;
-    offset = 0;
     line_info[n].chunks = 0;
-    do
-    {
-      if (!buf[offset])
-        break;
-
-      found = false;
-      null_rx = false;
-      struct ColorLineHead *head = NULL;
-      if (line_info[n].type == MT_COLOR_HDEFAULT)
-        head = &ColorHdrList;
-      else
-        head = &ColorBodyList;
-      STAILQ_FOREACH(color_line, head, entries)
-      {
-        if (regexec(&color_line->regex, buf + offset, 1, pmatch,
-                    (offset ? REG_NOTBOL : 0)) == 0)
-        {
-          if (pmatch[0].rm_eo != pmatch[0].rm_so)
-          {
-            if (!found)
-            {
-              /* Abort if we fill up chunks.
-               * Yes, this really happened. See #3888 */
-              if (line_info[n].chunks == SHRT_MAX)
-              {
-                null_rx = false;
-                break;
-              }
-              if (++(line_info[n].chunks) > 1)
-                mutt_mem_realloc(&(line_info[n].syntax),
-                                 (line_info[n].chunks) * sizeof(struct Syntax));
-            }
-            i = line_info[n].chunks - 1;
-            pmatch[0].rm_so += offset;
-            pmatch[0].rm_eo += offset;
-            if (!found || pmatch[0].rm_so < (line_info[n].syntax)[i].first ||
-                (pmatch[0].rm_so == (line_info[n].syntax)[i].first &&
-                 pmatch[0].rm_eo > (line_info[n].syntax)[i].last))
-            {
-              (line_info[n].syntax)[i].color = color_line->pair;
-              (line_info[n].syntax)[i].first = pmatch[0].rm_so;
-              (line_info[n].syntax)[i].last = pmatch[0].rm_eo;
-            }
-            found = true;
-            null_rx = false;
-          }
-          else
-            null_rx = true; /* empty regex; don't add it, but keep looking */
-        }
-      }
-
-      if (null_rx)
-        offset++; /* avoid degenerate cases */
-      else
-        offset = (line_info[n].syntax)[i].last;
-    } while (found || null_rx);
-    if (nl > 0)
-      buf[nl] = '\n';
+    line_info[n].colors_pending = true;
   }
 
   /* attachment patterns */
@@ -1599,6 +1662,25 @@ static int display_line(FILE *f, LOFF_T *last_pos, struct Line **line_info,
     goto out;
   }
 
+  /* colour the line, or the line this one continues, now it's on screen */
+  m = (*line_info)[n].continuation ? ((*line_info)[n].syntax)[0].first : n;
+  if ((flags & MUTT_SHOWCOLOR) && (*line_info)[m].colors_pending)
+  {
+    if (m == n)
+      resolve_body_colors((char *) fmt, *line_info, m);
+    else
+    {
+      unsigned char *mbuf = NULL, *mfmt = NULL;
+      size_t mbuflen = 0;
+      int mbuf_ready = 0;
+
+      if (fill_buffer(f, last_pos, (*line_info)[m].offset, &mbuf, &mfmt, &mbuflen, &mbuf_ready) >= 0)
+        resolve_body_colors((char *) mfmt, *line_info, m);
+      FREE(&mbuf);
+      FREE(&mfmt);
+    }
+  }
+
   /* display the line */
   format_line(line_info, n, buf, flags, &a, cnt, &ch, &vch, &col, &special, pager_window);
 
@@ -1753,6 +1835,7 @@ static void pager_menu_redraw(struct Menu *pager_menu)
     /* clear() doesn't optimize screen redraws */
     move(0, 0);
     clrtobot();
+    mutt_menu_forget_rows();
 
     if (IsHeader(rd->extra) && Context && ((Context->vcount + 1) < PagerIndexLines))
       rd->indexlen = Context->vcount + 1;
@@ -2167,6 +2250,9 @@ int mutt_pager(const char *banner, const char *fname, int flags, struct Pager *e
     {
       oldcount = Context ? Context->msgcount : 0;
       /* check for new mail */
+#ifdef USE_INOTIFY
+      MonitorContextChanged = false;
+#endif
       check = mx_check_mailbox(Context, &index_hint);
       if (check < 0)
       {
@@ -2275,7 +2361,11 @@ int mutt_pager(const char *banner, const char *fname, int flags, struct Pager *e
     if (ch < 0)
     {
       ch = 0;
-      mutt_timeout_hook();
+#ifdef USE_INOTIFY
+      /* woken up by a mailbox changing, not a real timeout */
+      if (!MonitorFilesChanged && !MonitorContextChanged)
+#endif
+        mutt_timeout_hook();
       continue;
     }
 
@@ -1150,7 +1150,7 @@ int mutt_parse_rfc822_line(struct Envelope *e, struct Header *hdr, char *line,
 struct Envelope *mutt_read_rfc822_header(FILE *f, struct Header *hdr,
                                          short user_hdrs, short weed)
 {
-  struct Envelope *e = mutt_new_envelope();
+  struct Envelope *e = mutt_new_pooled_envelope((hdr && hdr->pool) ? hdr->pool->envelopes : NULL);
   char *line = mutt_mem_malloc(LONG_STRING);
   char *p = NULL;
   LOFF_T loc;
@@ -1161,7 +1161,7 @@ struct Envelope *mutt_read_rfc822_header(FILE *f, struct Header *hdr,
   {
     if (!hdr->content)
     {
-      hdr->content = mutt_new_body();
+      hdr->content = mutt_new_pooled_body(hdr->pool ? hdr->pool->bodies : NULL);
 
       /* set the defaults from RFC1521 */
       hdr->content->type = TYPETEXT;
@@ -1293,6 +1293,10 @@ struct Envelope *mutt_read_rfc822_header(FILE *f, struct Header *hdr,
                     "from msg separator\n");
       hdr->date_sent = hdr->received;
     }
+
+    /* the emails of a mailbox share their common strings */
+    if (hdr->pool)
+      mutt_intern_envelope(e);
   }
 
   return e;
@@ -57,6 +57,7 @@
 #include "options.h"
 #include "pattern.h"
 #include "protos.h"
+#include "sort.h"
 #include "state.h"
 #include "thread.h"
 #ifdef USE_IMAP
@@ -78,6 +79,28 @@ enum EatRangeError
   RANGE_E_CTX,
 };
 
+/**
+ * is_literal - Can a regex be matched with a plain substring search?
+ * @param s Regex
+ * @retval true The regex contains no special characters
+ *
+ * Case-insensitive searches are only treated as literal if the string is
+ * ASCII, so that the byte-wise comparison agrees with REG_ICASE.
+ */
+static bool is_literal(const char *s)
+{
+  bool icase = (mutt_which_case(s) == REG_ICASE);
+
+  for (; *s; s++)
+  {
+    if (strchr("\\^$.[]|()*+?{}", *s))
+      return false;
+    if (icase && ((unsigned char) *s >= 0x80))
+      return false;
+  }
+  return true;
+}
+
 static bool eat_regex(struct Pattern *pat, struct Buffer *s, struct Buffer *err)
 {
   struct Buffer buf;
@@ -109,6 +132,13 @@ static bool eat_regex(struct Pattern *pat, struct Buffer *s, struct Buffer *err)
     pat->p.g = mutt_pattern_group(buf.data);
     FREE(&buf.data);
   }
+  else if (is_literal(buf.data))
+  {
+    pat->literal = true;
+    pat->p.str = mutt_str_strdup(buf.data);
+    pat->ign_case = mutt_which_case(buf.data) == REG_ICASE;
+    FREE(&buf.data);
+  }
   else
   {
     pat->p.regex = mutt_mem_malloc(sizeof(regex_t));
@@ -914,7 +944,7 @@ int mutt_which_case(const char *s)
 
 static int patmatch(const struct Pattern *pat, const char *buf)
 {
-  if (pat->stringmatch)
+  if (pat->stringmatch || pat->literal)
     return pat->ign_case ? !strcasestr(buf, pat->p.str) : !strstr(buf, pat->p.str);
   else if (pat->groupmatch)
     return !mutt_group_match(pat->p.g, buf);
@@ -922,6 +952,265 @@ static int patmatch(const struct Pattern *pat, const char *buf)
     return regexec(pat->p.regex, buf, 0, NULL, 0);
 }
 
+#ifdef HAVE_FOPENCOOKIE
+/**
+ * struct SearchStream - Match a pattern against text as it is decoded
+ *
+ * The stream is handed to mutt_copy_header() and mutt_body_handler() as their
+ * output, so the message is never stored in full.
+ */
+struct SearchStream
+{
+  const struct Pattern *pat; /**< Pattern to look for */
+  struct State *state;       /**< Told to stop once we have matched */
+  char *line;                /**< Current line, nul-terminated */
+  size_t linelen;            /**< Length of the current line */
+  size_t linemax;            /**< Allocated size of line */
+  bool unfold;               /**< Join header continuation lines */
+  bool pending;              /**< Line complete, but may be continued */
+  bool skipws;               /**< Eating indent of a continuation line */
+  bool eoh;                  /**< Seen the end of the headers */
+  bool match;                /**< The pattern has matched */
+};
+
+/**
+ * search_stream_append - Add some text to the current line
+ * @param ss  Search stream
+ * @param buf Text to add
+ * @param len Length of text
+ */
+static void search_stream_append(struct SearchStream *ss, const char *buf, size_t len)
+{
+  if (ss->linelen + len + 1 > ss->linemax)
+  {
+    ss->linemax = MAX(ss->linemax * 2, ss->linelen + len + 1);
+    mutt_mem_realloc(&ss->line, ss->linemax);
+  }
+  memcpy(ss->line + ss->linelen, buf, len);
+  ss->linelen += len;
+  ss->line[ss->linelen] = '\0';
+}
+
+/**
+ * search_stream_test - Match the current line and start a new one
+ * @param ss Search stream
+ */
+static void search_stream_test(struct SearchStream *ss)
+{
+  if (ss->line && (patmatch(ss->pat, ss->line) == 0))
+  {
+    ss->match = true;
+    ss->state->flags |= MUTT_STOP;
+  }
+  ss->linelen = 0;
+  if (ss->line)
+    ss->line[0] = '\0';
+}
+
+/**
+ * search_stream_header_char - Process one character of the headers
+ * @param ss Search stream
+ * @param c  Character
+ *
+ * Continuation lines are joined in the same way as mutt_read_rfc822_line().
+ */
+static void search_stream_header_char(struct SearchStream *ss, char c)
+{
+  if (ss->pending)
+  {
+    ss->pending = false;
+    if ((c == ' ') || (c == '\t'))
+    {
+      search_stream_append(ss, " ", 1);
+      ss->skipws = true;
+      return;
+    }
+    search_stream_test(ss);
+    if (ss->match)
+      return;
+  }
+
+  if (ss->skipws)
+  {
+    if ((c == ' ') || (c == '\t'))
+      return;
+    ss->skipws = false;
+  }
+
+  if (c != '\n')
+  {
+    search_stream_append(ss, &c, 1);
+    return;
+  }
+
+  /* a blank line, or one starting with a space, ends the headers */
+  if ((ss->linelen == 0) || ISSPACE(ss->line[0]))
+  {
+    ss->linelen = 0;
+    ss->eoh = true;
+    return;
+  }
+
+  while ((ss->linelen > 0) && ISSPACE(ss->line[ss->linelen - 1]))
+    ss->line[--ss->linelen] = '\0';
+  ss->pending = true;
+}
+
+/**
+ * search_stream_write - Match text written to the stream
+ * @param cookie Search stream
+ * @param buf    Text
+ * @param size   Length of text
+ * @retval num Always the full size; the rest is discarded after a match
+ */
+static ssize_t search_stream_write(void *cookie, const char *buf, size_t size)
+{
+  struct SearchStream *ss = cookie;
+  const char *end = buf + size;
+
+  if (ss->unfold)
+  {
+    for (; (buf < end) && !ss->match && !ss->eoh; buf++)
+      search_stream_header_char(ss, *buf);
+    return size;
+  }
+
+  while ((buf < end) && !ss->match)
+  {
+    const char *nl = memchr(buf, '\n', end - buf);
+    if (!nl)
+    {
+      search_stream_append(ss, buf, end - buf);
+      break;
+    }
+    /* keep the newline, the same as fgets() would */
+    search_stream_append(ss, buf, nl + 1 - buf);
+    search_stream_test(ss);
+    buf = nl + 1;
+  }
+
+  return size;
+}
+
+/**
+ * search_stream_close - Match whatever is left in the stream
+ * @param cookie Search stream
+ * @retval 0 Always
+ */
+static int search_stream_close(void *cookie)
+{
+  struct SearchStream *ss = cookie;
+
+  if (!ss->match && !ss->eoh && (ss->pending || (ss->linelen > 0)))
+    search_stream_test(ss);
+
+  FREE(&ss->line);
+  return 0;
+}
+
+/**
+ * msg_search_decoded - Search a decoded message, stopping at the first match
+ * @param ctx Mailbox
+ * @param pat Pattern to find
+ * @param h   Email
+ * @param msg Open message
+ * @retval 1 Pattern matches
+ * @retval 0 No match, or the message couldn't be decoded
+ */
+static int msg_search_decoded(struct Context *ctx, struct Pattern *pat,
+                              struct Header *h, struct Message *msg)
+{
+  static const cookie_io_functions_t search_stream_funcs = {
+    .write = search_stream_write, .close = search_stream_close,
+  };
+  struct SearchStream ss = { 0 };
+  struct State s = { 0 };
+
+  ss.pat = pat;
+  ss.state = &s;
+  ss.unfold = (pat->op == MUTT_HEADER);
+
+  s.fpin = msg->fp;
+  s.flags = MUTT_CHARCONV;
+  s.fpout = fopencookie(&ss, "w", search_stream_funcs);
+  if (!s.fpout)
+  {
+    mutt_perror(_("Error opening search stream"));
+    return 0;
+  }
+
+  if (pat->op != MUTT_BODY)
+  {
+    mutt_copy_header(msg->fp, h, s.fpout, CH_FROM | CH_DECODE, NULL);
+    fflush(s.fpout);
+  }
+
+  if ((pat->op != MUTT_HEADER) && !ss.match)
+  {
+    mutt_parse_mime_message(ctx, h);
+
+    if (WithCrypto && (h->security & ENCRYPT) && !crypt_valid_passphrase(h->security))
+    {
+      fclose(s.fpout);
+      return 0;
+    }
+
+    fseeko(msg->fp, h->offset, SEEK_SET);
+    mutt_body_handler(h->content, &s);
+  }
+
+  fclose(s.fpout);
+  return ss.match;
+}
+#endif
+
+/**
+ * literal_search - Search part of a file for a plain string
+ * @param pat Pattern with a literal string
+ * @param fp  File to search
+ * @param len Number of bytes to search
+ * @retval 1 The string was found
+ * @retval 0 No match
+ *
+ * The file is read in large blocks which are scanned with memmem().  The tail
+ * of each block is carried over, so matches straddling two blocks are found.
+ */
+static int literal_search(const struct Pattern *pat, FILE *fp, long len)
+{
+  const size_t blocksize = 65536;
+  size_t nlen = mutt_str_strlen(pat->p.str);
+  char *needle = mutt_str_strdup(pat->p.str);
+  char *buf = mutt_mem_malloc(blocksize + nlen);
+  size_t keep = 0;
+  int match = 0;
+
+  if (pat->ign_case)
+    mutt_str_strlower(needle);
+
+  while ((len > 0) && !match)
+  {
+    size_t got = fread(buf + keep, 1, MIN((size_t) len, blocksize), fp);
+    if (got == 0)
+      break;
+    len -= got;
+
+    if (pat->ign_case)
+      for (size_t i = keep; i < keep + got; i++)
+        buf[i] = tolower((unsigned char) buf[i]);
+
+    got += keep;
+    if (memmem(buf, got, needle, nlen))
+      match = 1;
+
+    keep = MIN(nlen - 1, got);
+    memmove(buf, buf + got - keep, keep);
+  }
+
+  FREE(&buf);
+  FREE(&needle);
+  return match;
+}
+
 static int msg_search(struct Context *ctx, struct Pattern *pat, int msgno)
 {
   struct Message *msg = NULL;
@@ -941,6 +1230,14 @@ static int msg_search(struct Context *ctx, struct Pattern *pat, int msgno)
 #endif
 
   msg = mx_open_message(ctx, msgno);
+#ifdef HAVE_FOPENCOOKIE
+  if (msg && option(OPT_THOROUGH_SEARCH))
+  {
+    match = msg_search_decoded(ctx, pat, h, msg);
+    mx_close_message(ctx, &msg);
+    return match;
+  }
+#endif
   if (msg)
   {
     if (option(OPT_THOROUGH_SEARCH))
@@ -1039,28 +1336,34 @@ static int msg_search(struct Context *ctx, struct Pattern *pat, int msgno)
       }
     }
 
-    blen = STRING;
-    buf = mutt_mem_malloc(blen);
-
-    /* search the file "fp" */
-    while (lng > 0)
+    /* a plain string never spans lines, so there's no need to split them */
+    if (pat->literal && (pat->op != MUTT_HEADER))
+      match = literal_search(pat, fp, lng);
+    else
     {
-      if (pat->op == MUTT_HEADER)
+      blen = STRING;
+      buf = mutt_mem_malloc(blen);
+
+      /* search the file "fp" */
+      while (lng > 0)
       {
-        if (*(buf = mutt_read_rfc822_line(fp, buf, &blen)) == '\0')
+        if (pat->op == MUTT_HEADER)
+        {
+          if (*(buf = mutt_read_rfc822_line(fp, buf, &blen)) == '\0')
+            break;
+        }
+        else if (fgets(buf, blen - 1, fp) == NULL)
+          break; /* don't loop forever */
+        if (patmatch(pat, buf) == 0)
+        {
+          match = 1;
           break;
+        }
+        lng -= mutt_str_strlen(buf);
       }
-      else if (fgets(buf, blen - 1, fp) == NULL)
-        break; /* don't loop forever */
-      if (patmatch(pat, buf) == 0)
-      {
-        match = 1;
-        break;
-      }
-      lng -= mutt_str_strlen(buf);
-    }
 
-    FREE(&buf);
+      FREE(&buf);
+    }
 
     mx_close_message(ctx, &msg);
 
@@ -1114,7 +1417,7 @@ void mutt_pattern_free(struct Pattern **pat)
     tmp = *pat;
     *pat = (*pat)->next;
 
-    if (tmp->stringmatch)
+    if (tmp->stringmatch || tmp->literal)
       FREE(&tmp->p.str);
     else if (tmp->groupmatch)
       tmp->p.g = NULL;
@@ -1912,6 +2215,140 @@ bool mutt_limit_current_thread(struct Header *h)
   return true;
 }
 
+/**
+ * pattern_needs_context - Does a pattern depend on other messages?
+ * @param pat Pattern to check
+ * @retval true The result for one message can change when another changes
+ */
+static bool pattern_needs_context(const struct Pattern *pat)
+{
+  for (; pat; pat = pat->next)
+  {
+    switch (pat->op)
+    {
+      case MUTT_THREAD:
+      case MUTT_PARENT:
+      case MUTT_CHILDREN:
+      case MUTT_DUPLICATED:
+      case MUTT_UNREFERENCED:
+        return true;
+    }
+    if (pattern_needs_context(pat->child))
+      return true;
+  }
+  return false;
+}
+
+/**
+ * limit_insert - Add a message to an unthreaded limited view
+ * @param ctx Mailbox
+ * @param h   Email to show
+ *
+ * v2r is in message order, so the message's slot is found by bisection.
+ */
+static void limit_insert(struct Context *ctx, struct Header *h)
+{
+  int lo = 0, hi = ctx->vcount;
+  struct Body *b = h->content;
+
+  while (lo < hi)
+  {
+    int mid = (lo + hi) / 2;
+    if (ctx->v2r[mid] < h->msgno)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  memmove(&ctx->v2r[lo + 1], &ctx->v2r[lo], (ctx->vcount - lo) * sizeof(int));
+  ctx->v2r[lo] = h->msgno;
+  ctx->vcount++;
+  ctx->vsize += b->length + b->offset - b->hdr_offset;
+
+  for (int i = lo; i < ctx->vcount; i++)
+    ctx->hdrs[ctx->v2r[i]]->virtual = i;
+}
+
+/**
+ * limit_remove - Remove a message from an unthreaded limited view
+ * @param ctx Mailbox
+ * @param h   Email to hide
+ */
+static void limit_remove(struct Context *ctx, struct Header *h)
+{
+  int pos = h->virtual;
+  struct Body *b = h->content;
+
+  if ((pos < 0) || (pos >= ctx->vcount))
+    return;
+
+  memmove(&ctx->v2r[pos], &ctx->v2r[pos + 1], (ctx->vcount - pos - 1) * sizeof(int));
+  ctx->vcount--;
+  ctx->vsize -= b->length + b->offset - b->hdr_offset;
+  h->virtual = -1;
+
+  for (int i = pos; i < ctx->vcount; i++)
+    ctx->hdrs[ctx->v2r[i]]->virtual = i;
+}
+
+/**
+ * mutt_limit_update - Re-check changed messages against the limit pattern
+ * @param ctx Mailbox
+ * @retval true The limited view changed
+ *
+ * Only messages marked limit_dirty (see $limit_refresh) are tested and, in an
+ * unthreaded view, v2r is patched in place.
+ *
+ * There are two fallbacks:
+ * - If the pattern looks at other messages (e.g. ~(...) or ~=), every message
+ *   is tested, because one change can alter the result for its neighbours.
+ * - In a threaded view, collapsed threads decide what's visible, so the new
+ *   membership is recorded and OPT_NEED_RESORT is set to rebuild the view.
+ */
+bool mutt_limit_update(struct Context *ctx)
+{
+  if (!ctx || !ctx->limit_dirty)
+    return false;
+
+  ctx->limit_dirty = false;
+
+  bool all = ctx->limit_pattern && pattern_needs_context(ctx->limit_pattern);
+  bool threaded = ((Sort & SORT_MASK) == SORT_THREADS);
+  bool changed = false;
+
+  for (int i = 0; i < ctx->msgcount; i++)
+  {
+    struct Header *h = ctx->hdrs[i];
+
+    if (!all && !h->limit_dirty)
+      continue;
+    h->limit_dirty = false;
+
+    if (!ctx->pattern || !ctx->limit_pattern)
+      continue;
+
+    bool match = mutt_pattern_exec(ctx->limit_pattern, MUTT_MATCH_FULL_ADDRESS,
+                                   ctx, h, NULL);
+    if (match == h->limited)
+      continue;
+
+    h->limited = match;
+    changed = true;
+
+    if (threaded)
+      h->virtual = match ? 0 : -1;
+    else if (match)
+      limit_insert(ctx, h);
+    else
+      limit_remove(ctx, h);
+  }
+
+  if (changed && threaded)
+    set_option(OPT_NEED_RESORT);
+
+  return changed;
+}
+
 int mutt_pattern_func(int op, char *prompt)
 {
   struct Pattern *pat = NULL;
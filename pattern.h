@@ -45,6 +45,7 @@ struct Pattern
   bool groupmatch : 1;
   bool ign_case : 1; /**< ignore case for local stringmatch searches */
   bool isalias : 1;
+  bool literal : 1; /**< regex has no special characters, p.str is a plain string */
   int min;
   int max;
   struct Pattern *next;
@@ -102,5 +103,6 @@ int mutt_pattern_func(int op, char *prompt);
 int mutt_search_command(int cur, int op);
 
 bool mutt_limit_current_thread(struct Header *h);
+bool mutt_limit_update(struct Context *ctx);
 
 #endif /* _MUTT_PATTERN_H */
@@ -186,7 +186,7 @@ static int fetch_uidl(char *line, void *data)
       mx_alloc_memory(ctx);
 
     ctx->msgcount++;
-    ctx->hdrs[i] = mutt_new_header();
+    ctx->hdrs[i] = mutt_new_pooled_header(ctx->hdr_pool);
     ctx->hdrs[i]->data = mutt_str_strdup(line);
   }
   else if (ctx->hdrs[i]->index != index - 1)
@@ -651,7 +651,10 @@ static int pop_fetch_message(struct Context *ctx, struct Message *msg, int msgno
    * portion of the headers, those required for the main display.
    */
   if (bcache)
+  {
+    fflush(msg->fp);
     mutt_bcache_commit(pop_data->bcache, h->data);
+  }
   else
   {
     cache->index = h->index;
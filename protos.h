@@ -353,6 +353,7 @@ int mutt_write_rfc822_header(FILE *fp, struct Envelope *env, struct Body *attach
 void mutt_write_references(const struct ListHead *r, FILE *f, size_t trim);
 int mutt_yesorno(const char *msg, int def);
 void mutt_set_header_color(struct Context *ctx, struct Header *curhdr);
+void mutt_index_line_invalidate(struct Header *h);
 void mutt_sleep(short s);
 int mutt_save_confirm(const char *s, struct stat *st);
 
@@ -898,7 +898,7 @@ void rfc2047_decode(char **pd)
   }
   *d = 0;
 
-  FREE(pd);
+  mutt_intern_release(pd);
   *pd = d0;
   mutt_str_adjust(pd);
 }
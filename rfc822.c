@@ -94,8 +94,8 @@ const char *const RFC822Errors[] = {
  */
 static void free_address(struct Address *a)
 {
-  FREE(&a->personal);
-  FREE(&a->mailbox);
+  mutt_intern_release(&a->personal);
+  mutt_intern_release(&a->mailbox);
   FREE(&a);
 }
 
@@ -148,8 +148,8 @@ void rfc822_free_address(struct Address **p)
   {
     t = *p;
     *p = (*p)->next;
-    FREE(&t->personal);
-    FREE(&t->mailbox);
+    mutt_intern_release(&t->personal);
+    mutt_intern_release(&t->mailbox);
     FREE(&t);
   }
 }
@@ -649,7 +649,7 @@ void rfc822_qualify(struct Address *addr, const char *host)
     {
       p = mutt_mem_malloc(mutt_str_strlen(addr->mailbox) + mutt_str_strlen(host) + 2);
       sprintf(p, "%s@%s", addr->mailbox, host);
-      FREE(&addr->mailbox);
+      mutt_intern_release(&addr->mailbox);
       addr->mailbox = p;
     }
 }
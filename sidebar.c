@@ -49,6 +49,17 @@
 /* Previous values for some sidebar config */
 static short PreviousSort = SORT_ORDER; /* sidebar_sort_method */
 
+/**
+ * struct SbCounts - Snapshot of a mailbox's message counts
+ */
+struct SbCounts
+{
+  int msg_count;   /**< total number of messages */
+  int msg_unread;  /**< number of unread messages */
+  int msg_flagged; /**< number of flagged messages */
+  bool new;        /**< mailbox has new mail */
+};
+
 /**
  * struct SbEntry - Info about folders in the sidebar
  */
@@ -57,11 +68,28 @@ struct SbEntry
   char box[STRING];    /**< formatted mailbox name */
   struct Buffy *buffy; /**< Mailbox this represents */
   bool is_hidden;      /**< Don't show, e.g. $sidebar_new_mail_only */
+
+  struct SbCounts sorted; /**< counts when the entry was last sorted */
+  struct SbCounts drawn;  /**< counts when the entry was last formatted */
+  char *display;          /**< cached formatted line, NULL if none */
+  int display_width;      /**< width the line was formatted for */
+  unsigned int display_gen; /**< DisplayGen when the line was formatted */
 };
 
 static int EntryCount = 0;
 static int EntryLen = 0;
 static struct SbEntry **Entries = NULL;
+static bool EntriesAdded = false; /**< Entries need sorting, a mailbox was added */
+
+/* Config that changes the look of every entry.  When it changes, DisplayGen
+ * is bumped and all the cached lines are rebuilt. */
+static unsigned int DisplayGen = 0;
+static char *PrevFormat = NULL;
+static char *PrevFolder = NULL;
+static char *PrevDelimChars = NULL;
+static char *PrevIndentString = NULL;
+static bool PrevShortPath = false;
+static bool PrevFolderIndent = false;
 
 static int TopIndex = -1; /**< First mailbox visible in sidebar */
 static int OpnIndex = -1; /**< Current (open) mailbox */
@@ -87,6 +115,83 @@ enum SidebarSrc
   SB_SRC_VIRT,     /**< Display virtual mailboxes */
 } sidebar_source = SB_SRC_INCOMING;
 
+/**
+ * get_counts - Take a snapshot of a mailbox's counts
+ * @param[in]  b Mailbox
+ * @param[out] c Counts
+ */
+static void get_counts(const struct Buffy *b, struct SbCounts *c)
+{
+  c->msg_count = b->msg_count;
+  c->msg_unread = b->msg_unread;
+  c->msg_flagged = b->msg_flagged;
+  c->new = b->new;
+}
+
+/**
+ * counts_equal - Have a mailbox's counts changed since a snapshot?
+ * @param b Mailbox
+ * @param c Snapshot of the counts
+ * @retval true The counts are unchanged
+ */
+static bool counts_equal(const struct Buffy *b, const struct SbCounts *c)
+{
+  return (c->msg_count == b->msg_count) && (c->msg_unread == b->msg_unread) &&
+         (c->msg_flagged == b->msg_flagged) && (c->new == b->new);
+}
+
+/**
+ * update_string - Keep a copy of a string config value
+ * @param prev Saved copy
+ * @param cur  Current value
+ * @retval true The value has changed
+ */
+static bool update_string(char **prev, const char *cur)
+{
+  if (mutt_str_strcmp(*prev, cur) == 0)
+    return false;
+
+  mutt_str_replace(prev, cur);
+  return true;
+}
+
+/**
+ * check_display_config - Invalidate the cached lines if the config has changed
+ */
+static void check_display_config(void)
+{
+  bool changed = false;
+
+  changed |= update_string(&PrevFormat, SidebarFormat);
+  changed |= update_string(&PrevFolder, Folder);
+  changed |= update_string(&PrevDelimChars, SidebarDelimChars);
+  changed |= update_string(&PrevIndentString, SidebarIndentString);
+
+  if ((PrevShortPath != option(OPT_SIDEBAR_SHORT_PATH)) ||
+      (PrevFolderIndent != option(OPT_SIDEBAR_FOLDER_INDENT)))
+  {
+    PrevShortPath = option(OPT_SIDEBAR_SHORT_PATH);
+    PrevFolderIndent = option(OPT_SIDEBAR_FOLDER_INDENT);
+    changed = true;
+  }
+
+  if (changed)
+    DisplayGen++;
+}
+
+/**
+ * free_entry - Free a sidebar entry
+ * @param sbe Entry to free
+ */
+static void free_entry(struct SbEntry **sbe)
+{
+  if (!sbe || !*sbe)
+    return;
+
+  FREE(&(*sbe)->display);
+  FREE(sbe);
+}
+
 /**
  * cb_format_str - Create the string to show in the sidebar
  * @param[out] dest        Buffer in which to save string
@@ -406,14 +511,38 @@ static void unsort_entries(void)
   }
 }
 
+/**
+ * insertion_sort_entries - Restore the order of a nearly sorted Entries array
+ *
+ * When only a few mailboxes' counts have changed, the array is almost in
+ * order.  An insertion sort then only costs one comparison per entry, plus the
+ * moves of the entries that are out of place.
+ */
+static void insertion_sort_entries(void)
+{
+  for (int i = 1; i < EntryCount; i++)
+  {
+    struct SbEntry *sbe = Entries[i];
+    int j = i;
+    while ((j > 0) && (cb_qsort_sbe(&Entries[j - 1], &sbe) > 0))
+    {
+      Entries[j] = Entries[j - 1];
+      j--;
+    }
+    Entries[j] = sbe;
+  }
+}
+
 /**
  * sort_entries - Sort Entries array
  *
  * Sort the Entries array according to the current sort config
- * option "sidebar_sort_method". This calls qsort to do the work which calls our
- * callback function "cb_qsort_sbe".
+ * option "sidebar_sort_method".
  *
- * Once sorted, the prev/next links will be reconstructed.
+ * A full sort, using qsort() and "cb_qsort_sbe", is only done when the sort
+ * method changes or mailboxes have been added.  Otherwise, the array is still
+ * in order unless the counts the order depends on have changed.  Then the few
+ * entries out of place are moved with an insertion sort.
  */
 static void sort_entries(void)
 {
@@ -421,9 +550,28 @@ static void sort_entries(void)
 
   /* These are the only sort methods we understand */
   if ((ssm == SORT_COUNT) || (ssm == SORT_UNREAD) || (ssm == SORT_FLAGGED) || (ssm == SORT_PATH))
-    qsort(Entries, EntryCount, sizeof(*Entries), cb_qsort_sbe);
+  {
+    bool resort = false;
+
+    for (int i = 0; i < EntryCount; i++)
+    {
+      if (!counts_equal(Entries[i]->buffy, &Entries[i]->sorted))
+      {
+        get_counts(Entries[i]->buffy, &Entries[i]->sorted);
+        if (ssm != SORT_PATH)
+          resort = true;
+      }
+    }
+
+    if (EntriesAdded || (SidebarSortMethod != PreviousSort))
+      qsort(Entries, EntryCount, sizeof(*Entries), cb_qsort_sbe);
+    else if (resort)
+      insertion_sort_entries();
+  }
   else if ((ssm == SORT_ORDER) && (SidebarSortMethod != PreviousSort))
     unsort_entries();
+
+  EntriesAdded = false;
 }
 
 /**
@@ -587,8 +735,9 @@ static int select_page_up(void)
  * Before painting the sidebar, we determine which are visible, sort
  * them and set up our page pointers.
  *
- * This is a lot of work to do each refresh, but there are many things that
- * can change outside of the sidebar that we don't hear about.
+ * There are many things that can change outside of the sidebar that we don't
+ * hear about, so the mailboxes' counts are compared with those seen last
+ * time.  The Entries are only re-sorted if they have changed.
  */
 static bool prepare_sidebar(int page_size)
 {
@@ -795,6 +944,10 @@ static void fill_empty_space(int first_row, int num_rows, int div_width, int num
  * "sidebar_short_path", indented: "sidebar_folder_indent",
  * "sidebar_indent_string" and sorted: "sidebar_sort_method".  Finally, they're
  * trimmed to fit the available space.
+ *
+ * Each entry keeps the line it was last drawn with.  It's reused until the
+ * mailbox's counts, the width or the config above change.  The open mailbox's
+ * line is never kept, so it can't be reused once another mailbox is opened.
  */
 static void draw_sidebar(int num_rows, int num_cols, int div_width)
 {
@@ -805,6 +958,8 @@ static void draw_sidebar(int num_rows, int num_cols, int div_width)
 
   int w = MIN(num_cols, (SidebarWidth - div_width));
   int row = 0;
+
+  check_display_config();
   for (int entryidx = TopIndex; (entryidx < EntryCount) && (row < num_rows); entryidx++)
   {
     entry = Entries[entryidx];
@@ -841,8 +996,9 @@ static void draw_sidebar(int num_rows, int num_cols, int div_width)
       col = div_width;
 
     mutt_window_move(MuttSidebarWindow, row, col);
-    if (Context && Context->realpath &&
-        (mutt_str_strcmp(b->realpath, Context->realpath) == 0))
+    bool is_open = Context && Context->realpath &&
+                   (mutt_str_strcmp(b->realpath, Context->realpath) == 0);
+    if (is_open)
     {
 #ifdef USE_NOTMUCH
       if (b->magic == MUTT_NOTMUCH)
@@ -856,6 +1012,15 @@ static void draw_sidebar(int num_rows, int num_cols, int div_width)
       b->msg_flagged = Context->flagged;
     }
 
+    /* Reuse the line we formatted last time, if nothing it shows has changed */
+    if (!is_open && entry->display && (entry->display_width == w) &&
+        (entry->display_gen == DisplayGen) && counts_equal(b, &entry->drawn))
+    {
+      printw("%s", entry->display);
+      row++;
+      continue;
+    }
+
     /* compute length of Folder without trailing separator */
     size_t maildirlen = mutt_str_strlen(Folder);
     if (maildirlen && SidebarDelimChars && strchr(SidebarDelimChars, Folder[maildirlen - 1]))
@@ -921,6 +1086,17 @@ static void draw_sidebar(int num_rows, int num_cols, int div_width)
     char str[STRING];
     make_sidebar_entry(str, sizeof(str), w, sidebar_folder_name, entry);
     printw("%s", str);
+    /* the open mailbox's line shows its Context's deleted, tagged and limited
+     * counts, which aren't part of the key, so don't keep it */
+    if (is_open)
+      FREE(&entry->display);
+    else
+    {
+      mutt_str_replace(&entry->display, str);
+      entry->display_width = w;
+      entry->display_gen = DisplayGen;
+      get_counts(b, &entry->drawn);
+    }
     if (sidebar_folder_depth > 0)
       FREE(&sidebar_folder_name);
     row++;
@@ -1117,6 +1293,8 @@ void mutt_sb_notify_mailbox(struct Buffy *b, int created)
     }
     Entries[EntryCount] = mutt_mem_calloc(1, sizeof(struct SbEntry));
     Entries[EntryCount]->buffy = b;
+    get_counts(b, &Entries[EntryCount]->sorted);
+    EntriesAdded = true;
 
     if (TopIndex < 0)
       TopIndex = EntryCount;
@@ -1134,7 +1312,7 @@ void mutt_sb_notify_mailbox(struct Buffy *b, int created)
         break;
     if (del_index == EntryCount)
       return;
-    FREE(&Entries[del_index]);
+    free_entry(&Entries[del_index]);
     EntryCount--;
 
     if (TopIndex > del_index || TopIndex == EntryCount)
@@ -1173,6 +1351,8 @@ void mutt_sb_toggle_virtual(void)
   BotIndex = -1;
 
   /* First clear all the sidebar entries */
+  for (int i = 0; i < EntryCount; i++)
+    free_entry(&Entries[i]);
   EntryCount = 0;
   FREE(&Entries);
   EntryLen = 0;
@@ -21,6 +21,8 @@
  */
 
 #include "config.h"
+#include <ctype.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include "mutt/mutt.h"
@@ -46,6 +48,26 @@
 /* function to use as discriminator when normal sort method is equal */
 static sort_t *AuxSort = NULL;
 
+/**
+ * struct SortKey - String sort keys, extracted once per sort
+ *
+ * The strings are already folded to lower case, so the comparison functions
+ * only need a plain strcmp().  The array is indexed by Header.index.
+ */
+struct SortKey
+{
+  struct Header *hdr; /**< owner of this entry, to detect stale lookups */
+  char *from;         /**< folded name of the first From: address */
+  char *to;           /**< folded name of the first To: address */
+  char *subj;         /**< folded real subject, NULL if the message has none */
+};
+
+static struct SortKey *SortKeys = NULL;
+static int SortKeysCount = 0;
+
+/* below this many messages, qsort() beats the setup cost of a radix sort */
+#define RADIX_SORT_MIN 1024
+
 static int perform_auxsort(int retval, const void *a, const void *b)
 {
   /* If the items compared equal by the main sort
@@ -63,6 +85,20 @@ static int perform_auxsort(int retval, const void *a, const void *b)
   return retval;
 }
 
+/**
+ * sort_key - Find the precomputed string keys of a message
+ * @param h Header of the message
+ * @retval ptr  Sort keys
+ * @retval NULL No keys have been extracted for this message
+ */
+static struct SortKey *sort_key(const struct Header *h)
+{
+  if (!SortKeys || (h->index < 0) || (h->index >= SortKeysCount))
+    return NULL;
+  struct SortKey *key = &SortKeys[h->index];
+  return (key->hdr == h) ? key : NULL;
+}
+
 static int compare_score(const void *a, const void *b)
 {
   struct Header **pa = (struct Header **) a;
@@ -94,6 +130,8 @@ static int compare_subject(const void *a, const void *b)
 {
   struct Header **pa = (struct Header **) a;
   struct Header **pb = (struct Header **) b;
+  struct SortKey *ka = sort_key(*pa);
+  struct SortKey *kb = sort_key(*pb);
   int rc;
 
   if (!(*pa)->env->real_subj)
@@ -105,6 +143,8 @@ static int compare_subject(const void *a, const void *b)
   }
   else if (!(*pb)->env->real_subj)
     rc = 1;
+  else if (ka && kb && ka->subj && kb->subj)
+    rc = strcmp(ka->subj, kb->subj);
   else
     rc = mutt_str_strcasecmp((*pa)->env->real_subj, (*pb)->env->real_subj);
   rc = perform_auxsort(rc, a, b);
@@ -132,13 +172,20 @@ static int compare_to(const void *a, const void *b)
 {
   struct Header **ppa = (struct Header **) a;
   struct Header **ppb = (struct Header **) b;
+  struct SortKey *ka = sort_key(*ppa);
+  struct SortKey *kb = sort_key(*ppb);
   char fa[SHORT_STRING];
   const char *fb = NULL;
   int result;
 
-  mutt_str_strfcpy(fa, mutt_get_name((*ppa)->env->to), SHORT_STRING);
-  fb = mutt_get_name((*ppb)->env->to);
-  result = mutt_str_strncasecmp(fa, fb, SHORT_STRING);
+  if (ka && kb && ka->to && kb->to)
+    result = strcmp(ka->to, kb->to);
+  else
+  {
+    mutt_str_strfcpy(fa, mutt_get_name((*ppa)->env->to), SHORT_STRING);
+    fb = mutt_get_name((*ppb)->env->to);
+    result = mutt_str_strncasecmp(fa, fb, SHORT_STRING);
+  }
   result = perform_auxsort(result, a, b);
   return (SORTCODE(result));
 }
@@ -147,13 +194,20 @@ static int compare_from(const void *a, const void *b)
 {
   struct Header **ppa = (struct Header **) a;
   struct Header **ppb = (struct Header **) b;
+  struct SortKey *ka = sort_key(*ppa);
+  struct SortKey *kb = sort_key(*ppb);
   char fa[SHORT_STRING];
   const char *fb = NULL;
   int result;
 
-  mutt_str_strfcpy(fa, mutt_get_name((*ppa)->env->from), SHORT_STRING);
-  fb = mutt_get_name((*ppb)->env->from);
-  result = mutt_str_strncasecmp(fa, fb, SHORT_STRING);
+  if (ka && kb && ka->from && kb->from)
+    result = strcmp(ka->from, kb->from);
+  else
+  {
+    mutt_str_strfcpy(fa, mutt_get_name((*ppa)->env->from), SHORT_STRING);
+    fb = mutt_get_name((*ppb)->env->from);
+    result = mutt_str_strncasecmp(fa, fb, SHORT_STRING);
+  }
   result = perform_auxsort(result, a, b);
   return (SORTCODE(result));
 }
@@ -303,6 +357,223 @@ sort_t *mutt_get_sort_func(int method)
   /* not reached */
 }
 
+/**
+ * fold_key - Make a lower-case copy of a string, for use as a sort key
+ * @param s   String to copy
+ * @param len Maximum number of bytes to copy, including the terminator
+ * @retval ptr New string, which the caller must free
+ */
+static char *fold_key(const char *s, size_t len)
+{
+  char *key = mutt_mem_malloc(len);
+  mutt_str_strfcpy(key, s, len);
+  for (char *p = key; *p; p++)
+    *p = tolower((unsigned char) *p);
+  return key;
+}
+
+/**
+ * sort_keys_free - Release the precomputed string keys
+ */
+static void sort_keys_free(void)
+{
+  for (int i = 0; i < SortKeysCount; i++)
+  {
+    FREE(&SortKeys[i].from);
+    FREE(&SortKeys[i].to);
+    FREE(&SortKeys[i].subj);
+  }
+  FREE(&SortKeys);
+  SortKeysCount = 0;
+}
+
+/**
+ * sort_keys_init - Extract the string keys needed by the current sort
+ * @param ctx Mailbox
+ *
+ * Looking up the names (which may involve a reverse alias lookup and an IDN
+ * conversion) and folding the case is done once per message, rather than on
+ * every comparison.
+ */
+static void sort_keys_init(struct Context *ctx)
+{
+  bool from = false, to = false, subj = false;
+  int methods[2] = { Sort & SORT_MASK, SortAux & SORT_MASK };
+
+  for (int i = 0; i < 2; i++)
+  {
+    if (methods[i] == SORT_FROM)
+      from = true;
+    else if (methods[i] == SORT_TO)
+      to = true;
+    else if (methods[i] == SORT_SUBJECT)
+      subj = true;
+  }
+
+  if (!from && !to && !subj)
+    return;
+
+  /* The keys are indexed by Header.index, which must be unique */
+  int count = 0;
+  for (int i = 0; i < ctx->msgcount; i++)
+    if (ctx->hdrs[i]->index >= count)
+      count = ctx->hdrs[i]->index + 1;
+
+  SortKeys = mutt_mem_calloc(count, sizeof(struct SortKey));
+  SortKeysCount = count;
+
+  for (int i = 0; i < ctx->msgcount; i++)
+  {
+    struct Header *h = ctx->hdrs[i];
+    struct SortKey *key = &SortKeys[h->index];
+
+    if (h->index < 0 || key->hdr)
+    {
+      /* duplicate or bogus index: use the slow path for everything */
+      sort_keys_free();
+      return;
+    }
+
+    key->hdr = h;
+    if (from)
+      key->from = fold_key(mutt_get_name(h->env->from), SHORT_STRING);
+    if (to)
+      key->to = fold_key(mutt_get_name(h->env->to), SHORT_STRING);
+    if (subj && h->env->real_subj)
+      key->subj = fold_key(h->env->real_subj, mutt_str_strlen(h->env->real_subj) + 1);
+  }
+}
+
+/**
+ * struct RadixItem - A message and its integer sort key
+ */
+struct RadixItem
+{
+  uint64_t key;
+  struct Header *hdr;
+};
+
+/**
+ * radix_key - Get the integer sort key of a message
+ * @param ctx    Mailbox
+ * @param method Sort method, e.g. #SORT_DATE
+ * @param h      Header of the message
+ * @param key    Key, ordered the same way as the sort function
+ * @retval true  The sort method has an integer key
+ * @retval false The message must be sorted by its comparison function
+ */
+static bool radix_key(struct Context *ctx, int method, struct Header *h, uint64_t *key)
+{
+  int64_t k;
+
+  switch (method & SORT_MASK)
+  {
+    case SORT_DATE:
+      k = h->date_sent;
+      break;
+    case SORT_RECEIVED:
+      k = h->received;
+      break;
+    case SORT_SIZE:
+      k = h->content->length;
+      break;
+    case SORT_SCORE:
+      k = -(int64_t) h->score; /* highest score first */
+      break;
+    case SORT_ORDER:
+#ifdef USE_NNTP
+      if (ctx->magic == MUTT_NNTP)
+        return false;
+#endif
+      k = h->index;
+      break;
+    default:
+      return false;
+  }
+
+  /* flip the sign bit so that the keys can be compared as unsigned */
+  *key = (uint64_t) k ^ ((uint64_t) 1 << 63);
+  if (method & SORT_REVERSE)
+    *key = ~*key;
+  return true;
+}
+
+/**
+ * radix_sort_headers - Sort the messages by an integer key
+ * @param ctx      Mailbox
+ * @param sortfunc Comparison function for the current sort method
+ * @retval true  The messages have been sorted
+ * @retval false The sort method has no integer key, use qsort()
+ *
+ * An LSD radix sort on the primary key puts the messages in order.  Runs of
+ * messages with equal keys are then sorted with the comparison function,
+ * which applies $sort_aux and the index tie-breaks exactly as qsort() would.
+ */
+static bool radix_sort_headers(struct Context *ctx, sort_t *sortfunc)
+{
+  const int n = ctx->msgcount;
+
+  if (n < RADIX_SORT_MIN)
+    return false;
+
+  struct RadixItem *src = mutt_mem_malloc(n * sizeof(struct RadixItem));
+  for (int i = 0; i < n; i++)
+  {
+    if (!radix_key(ctx, Sort, ctx->hdrs[i], &src[i].key))
+    {
+      FREE(&src);
+      return false;
+    }
+    src[i].hdr = ctx->hdrs[i];
+  }
+
+  struct RadixItem *dst = mutt_mem_malloc(n * sizeof(struct RadixItem));
+  size_t counts[256];
+
+  for (int shift = 0; shift < 64; shift += 8)
+  {
+    memset(counts, 0, sizeof(counts));
+    for (int i = 0; i < n; i++)
+      counts[(src[i].key >> shift) & 0xff]++;
+
+    /* every key has the same byte here, nothing to do */
+    if (counts[(src[0].key >> shift) & 0xff] == (size_t) n)
+      continue;
+
+    size_t pos = 0;
+    for (int i = 0; i < 256; i++)
+    {
+      size_t c = counts[i];
+      counts[i] = pos;
+      pos += c;
+    }
+
+    for (int i = 0; i < n; i++)
+      dst[counts[(src[i].key >> shift) & 0xff]++] = src[i];
+
+    struct RadixItem *tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+
+  for (int i = 0; i < n; i++)
+    ctx->hdrs[i] = src[i].hdr;
+
+  for (int i = 0; i < n;)
+  {
+    int j = i + 1;
+    while ((j < n) && (src[j].key == src[i].key))
+      j++;
+    if ((j - i) > 1)
+      qsort((void *) &ctx->hdrs[i], j - i, sizeof(struct Header *), sortfunc);
+    i = j;
+  }
+
+  FREE(&src);
+  FREE(&dst);
+  return true;
+}
+
 void mutt_sort_headers(struct Context *ctx, int init)
 {
   struct Header *h = NULL;
@@ -314,6 +585,10 @@ void mutt_sort_headers(struct Context *ctx, int init)
   if (!ctx)
     return;
 
+  /* only mutt_sort_threads() can make use of this */
+  if ((Sort & SORT_MASK) != SORT_THREADS)
+    unset_option(OPT_SORT_NEW_MAIL);
+
   if (!ctx->msgcount)
   {
     /* this function gets called by mutt_sync_mailbox(), which may have just
@@ -322,6 +597,7 @@ void mutt_sort_headers(struct Context *ctx, int init)
      */
     ctx->vcount = 0;
     mutt_clear_threads(ctx);
+    unset_option(OPT_SORT_NEW_MAIL);
     return; /* nothing to do! */
   }
 
@@ -344,6 +620,8 @@ void mutt_sort_headers(struct Context *ctx, int init)
   if (init && ctx->tree)
     mutt_clear_threads(ctx);
 
+  sort_keys_init(ctx);
+
   if ((Sort & SORT_MASK) == SORT_THREADS)
   {
     AuxSort = NULL;
@@ -363,13 +641,16 @@ void mutt_sort_headers(struct Context *ctx, int init)
   else if ((sortfunc = mutt_get_sort_func(Sort)) == NULL ||
            (AuxSort = mutt_get_sort_func(SortAux)) == NULL)
   {
+    sort_keys_free();
     mutt_error(_("Could not find sorting function! [report this bug]"));
     mutt_sleep(1);
     return;
   }
-  else
+  else if (!radix_sort_headers(ctx, sortfunc))
     qsort((void *) ctx->hdrs, ctx->msgcount, sizeof(struct Header *), sortfunc);
 
+  sort_keys_free();
+
   /* adjust the virtual message numbers */
   ctx->vcount = 0;
   for (int i = 0; i < ctx->msgcount; i++)
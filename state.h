@@ -46,6 +46,7 @@ struct State
 #define MUTT_PRINTING      (1 << 5) /**< are we printing? - MUTT_DISPLAY "light" */
 #define MUTT_REPLYING      (1 << 6) /**< are we replying? */
 #define MUTT_FIRSTDONE     (1 << 7) /**< the first attachment has been done */
+#define MUTT_STOP          (1 << 8) /**< the consumer of fpout needs no more output */
 
 #define state_set_prefix(s) ((s)->flags |= MUTT_PENDINGPREFIX)
 #define state_reset_prefix(s) ((s)->flags &= ~MUTT_PENDINGPREFIX)
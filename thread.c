@@ -42,6 +42,17 @@ static bool is_visible(struct Header *hdr, struct Context *ctx)
   return (hdr->virtual >= 0 || (hdr->collapsed && (!ctx->pattern || hdr->limited)));
 }
 
+/**
+ * same_subject - Are two real subjects the same?
+ *
+ * The subjects of a mailbox's emails are interned, so equal subjects usually
+ * have the same address and the string compare can be skipped.
+ */
+static bool same_subject(const char *a, const char *b)
+{
+  return (a == b) || (mutt_str_strcmp(a, b) == 0);
+}
+
 /**
  * is_descendant - Is one thread a descendant of another
  */
@@ -140,9 +151,10 @@ static void linearize_tree(struct Context *ctx)
  * this calculates whether a node is the root of a subtree that has visible
  * nodes, whether a node itself is visible, whether, if invisible, it has
  * depth anyway, and whether any of its later siblings are roots of visible
- * subtrees.  while it's at it, it frees the old thread display, so we can
- * skip parts of the tree in mutt_draw_tree() if we've decided here that we
- * don't care about them any more.
+ * subtrees.  while it's at it, it frees the thread display of invisible
+ * messages, so we can skip parts of the tree in mutt_draw_tree() if we've
+ * decided here that we don't care about them any more.  visible messages keep
+ * theirs, so mutt_draw_tree() can reuse it if it hasn't changed.
  */
 static void calculate_visibility(struct Context *ctx, int *max_depth)
 {
@@ -164,7 +176,6 @@ static void calculate_visibility(struct Context *ctx, int *max_depth)
     tree->subtree_visible = 0;
     if (tree->message)
     {
-      FREE(&tree->message->tree);
       if (is_visible(tree->message, ctx))
       {
         tree->deep = true;
@@ -184,6 +195,7 @@ static void calculate_visibility(struct Context *ctx, int *max_depth)
       }
       else
       {
+        FREE(&tree->message->tree);
         tree->visible = false;
         tree->deep = !option(OPT_HIDE_LIMITED);
       }
@@ -269,6 +281,7 @@ void mutt_draw_tree(struct Context *ctx)
   calculate_visibility(ctx, &max_depth);
   pfx = mutt_mem_malloc(width * max_depth + 2);
   arrow = mutt_mem_malloc(width * max_depth + 2);
+  new_tree = mutt_mem_malloc(width * max_depth + 2);
   while (tree)
   {
     if (depth)
@@ -289,7 +302,6 @@ void mutt_draw_tree(struct Context *ctx)
       {
         myarrow[width] = MUTT_TREE_RARROW;
         myarrow[width + 1] = 0;
-        new_tree = mutt_mem_malloc((2 + depth * width));
         if (start_depth > 1)
         {
           strncpy(new_tree, pfx, (start_depth - 1) * width);
@@ -298,9 +310,17 @@ void mutt_draw_tree(struct Context *ctx)
         }
         else
           mutt_str_strfcpy(new_tree, arrow, 2 + depth * width);
-        tree->message->tree = new_tree;
+
+        /* most of the tree is unchanged between redraws */
+        if (mutt_str_strcmp(tree->message->tree, new_tree) != 0)
+        {
+          FREE(&tree->message->tree);
+          tree->message->tree = mutt_str_strdup(new_tree);
+        }
       }
     }
+    else if (tree->visible)
+      FREE(&tree->message->tree);
     if (tree->child && depth)
     {
       mypfx = pfx + (depth - 1) * width;
@@ -364,6 +384,7 @@ void mutt_draw_tree(struct Context *ctx)
 
   FREE(&pfx);
   FREE(&arrow);
+  FREE(&new_tree);
 }
 
 /**
@@ -400,7 +421,7 @@ static void make_subject_list(struct ListHead *subjects, struct MuttThread *cur,
       struct ListNode *np;
       STAILQ_FOREACH(np, subjects, entries)
       {
-        rc = mutt_str_strcmp(env->real_subj, np->data);
+        rc = (env->real_subj == np->data) ? 0 : mutt_str_strcmp(env->real_subj, np->data);
         if (rc >= 0)
           break;
       }
@@ -451,7 +472,7 @@ static struct MuttThread *find_subject(struct Context *ctx, struct MuttThread *c
                          (last->message->received < tmp->message->received) :
                          (last->message->date_sent < tmp->message->date_sent))) &&
           tmp->message->env->real_subj &&
-          (mutt_str_strcmp(np->data, tmp->message->env->real_subj) == 0))
+          same_subject(np->data, tmp->message->env->real_subj))
       {
         last = tmp; /* best match so far */
       }
@@ -510,7 +531,7 @@ static struct Hash *make_subj_hash(struct Context *ctx)
   struct Header *hdr = NULL;
   struct Hash *hash = NULL;
 
-  hash = mutt_hash_create(ctx->msgcount * 2, MUTT_HASH_ALLOW_DUPS);
+  hash = mutt_hash_create(ctx->msgcount, MUTT_HASH_ALLOW_DUPS);
 
   for (int i = 0; i < ctx->msgcount; i++)
   {
@@ -524,10 +545,12 @@ static struct Hash *make_subj_hash(struct Context *ctx)
 
 /**
  * pseudo_threads - Thread messages by subject
+ * @param ctx      Mailbox
+ * @param new_only Only look at threads marked check_pseudo
  *
  * Thread by subject things that didn't get threaded by message-id
  */
-static void pseudo_threads(struct Context *ctx)
+static void pseudo_threads(struct Context *ctx, bool new_only)
 {
   struct MuttThread *tree = ctx->tree, *top = tree;
   struct MuttThread *tmp = NULL, *cur = NULL, *parent = NULL, *curchild = NULL,
@@ -540,6 +563,12 @@ static void pseudo_threads(struct Context *ctx)
   {
     cur = tree;
     tree = tree->next;
+
+    /* only threads touched by new mail can have gained a parent */
+    if (new_only && !cur->check_pseudo)
+      continue;
+    cur->check_pseudo = false;
+
     parent = find_subject(ctx, cur);
     if (parent)
     {
@@ -558,8 +587,8 @@ static void pseudo_threads(struct Context *ctx)
          * but only do this if they have the same real subject as the
          * parent, since otherwise they rightly belong to the message
          * we're attaching. */
-        if (tmp == cur || (mutt_str_strcmp(tmp->message->env->real_subj,
-                                           parent->message->env->real_subj) == 0))
+        if (tmp == cur ||
+            same_subject(tmp->message->env->real_subj, parent->message->env->real_subj))
         {
           tmp->message->subject_changed = false;
 
@@ -601,8 +630,10 @@ void mutt_clear_threads(struct Context *ctx)
   }
   ctx->tree = NULL;
 
+  /* the threads themselves are owned by the pool */
   if (ctx->thread_hash)
-    mutt_hash_destroy(&ctx->thread_hash, *free);
+    mutt_hash_destroy(&ctx->thread_hash, NULL);
+  mutt_pool_destroy(&ctx->thread_pool);
 }
 
 static int compare_threads(const void *a, const void *b)
@@ -773,13 +804,71 @@ static void check_subjects(struct Context *ctx, int init)
       cur->subject_changed = true;
     else if (cur->env->real_subj && tmp->message->env->real_subj)
       cur->subject_changed =
-          (mutt_str_strcmp(cur->env->real_subj, tmp->message->env->real_subj) != 0) ? true : false;
+          !same_subject(cur->env->real_subj, tmp->message->env->real_subj);
     else
       cur->subject_changed =
           (cur->env->real_subj || tmp->message->env->real_subj) ? true : false;
   }
 }
 
+/**
+ * unlink_pseudo_children - Detach the pseudo-threads below a message
+ * @param thread Thread whose children to check
+ * @param top    Temporary top node to attach them to
+ *
+ * The pseudo-threads might belong to a newly arrived message instead.
+ */
+static void unlink_pseudo_children(struct MuttThread *thread, struct MuttThread *top)
+{
+  struct MuttThread *child = NULL, *tmp = NULL;
+
+  for (child = thread->child; child;)
+  {
+    tmp = child->next;
+    if (child->fake_thread)
+    {
+      unlink_message(&thread->child, child);
+      insert_message(&top->child, top, child);
+      child->fake_thread = false;
+      child->check_pseudo = true;
+    }
+    child = tmp;
+  }
+}
+
+/**
+ * mark_subject_threads - Prepare the threads sharing a new message's subject
+ * @param ctx Mailbox
+ * @param hdr Newly arrived message
+ * @param top Temporary top node
+ *
+ * Only messages with the same real subject as a new message can be affected
+ * by its arrival: their pseudo-threads are detached and the roots of their
+ * threads are marked to be checked by pseudo_threads().
+ */
+static void mark_subject_threads(struct Context *ctx, struct Header *hdr,
+                                 struct MuttThread *top)
+{
+  struct HashElem *ptr = NULL;
+  struct MuttThread *root = NULL;
+
+  if (!hdr->env->real_subj)
+    return;
+
+  for (ptr = mutt_hash_find_bucket(ctx->subj_hash, hdr->env->real_subj); ptr; ptr = ptr->next)
+  {
+    struct Header *h = ptr->data;
+    if (!h->thread || !same_subject(hdr->env->real_subj, h->env->real_subj))
+      continue;
+
+    unlink_pseudo_children(h->thread, top);
+
+    for (root = h->thread; root->parent && (root->parent != top); root = root->parent)
+      ;
+    root->check_pseudo = true;
+  }
+}
+
 void mutt_sort_threads(struct Context *ctx, int init)
 {
   struct Header *cur = NULL;
@@ -787,6 +876,13 @@ void mutt_sort_threads(struct Context *ctx, int init)
   struct MuttThread *thread = NULL, *new = NULL, *tmp = NULL, top;
   memset(&top, 0, sizeof(top));
   struct ListNode *ref = NULL;
+  struct Header **new_hdrs = NULL;
+  int new_count = 0, new_max = 0;
+
+  /* if only new mail has arrived, the existing threads are still valid and
+   * only the pseudo-threads sharing a subject with new mail are rebuilt */
+  bool new_only = !init && ctx->tree && ctx->subj_hash && option(OPT_SORT_NEW_MAIL);
+  unset_option(OPT_SORT_NEW_MAIL);
 
   /* set Sort to the secondary method to support the set sort_aux=reverse-*
    * settings.  The sorting functions just look at the value of
@@ -799,7 +895,11 @@ void mutt_sort_threads(struct Context *ctx, int init)
     init = 1;
 
   if (init)
-    ctx->thread_hash = mutt_hash_create(ctx->msgcount * 2, MUTT_HASH_ALLOW_DUPS);
+  {
+    ctx->thread_hash = mutt_hash_create(ctx->msgcount, MUTT_HASH_ALLOW_DUPS);
+    if (!ctx->thread_pool)
+      ctx->thread_pool = mutt_pool_create(sizeof(struct MuttThread), 1024);
+  }
 
   /* we want a quick way to see if things are actually attached to the top of the
    * thread tree or if they're just dangling, so we attach everything to a top
@@ -819,6 +919,13 @@ void mutt_sort_threads(struct Context *ctx, int init)
 
     if (!cur->thread)
     {
+      if (new_only)
+      {
+        if (new_count >= new_max)
+          mutt_mem_realloc(&new_hdrs, (new_max += 256) * sizeof(struct Header *));
+        new_hdrs[new_count++] = cur;
+      }
+
       if ((!init || option(OPT_DUPLICATE_THREADS)) && cur->env->message_id)
         thread = mutt_hash_find(ctx->thread_hash, cur->env->message_id);
       else
@@ -865,7 +972,7 @@ void mutt_sort_threads(struct Context *ctx, int init)
       {
         new = (option(OPT_DUPLICATE_THREADS) ? thread : NULL);
 
-        thread = mutt_mem_calloc(1, sizeof(struct MuttThread));
+        thread = mutt_pool_alloc(ctx->thread_pool);
         thread->message = cur;
         thread->check_subject = true;
         cur->thread = thread;
@@ -885,25 +992,17 @@ void mutt_sort_threads(struct Context *ctx, int init)
         }
       }
     }
-    else
+    else if (!new_only)
     {
       /* unlink pseudo-threads because they might be children of newly
        * arrived messages */
-      thread = cur->thread;
-      for (new = thread->child; new;)
-      {
-        tmp = new->next;
-        if (new->fake_thread)
-        {
-          unlink_message(&thread->child, new);
-          insert_message(&top.child, &top, new);
-          new->fake_thread = false;
-        }
-        new = tmp;
-      }
+      unlink_pseudo_children(cur->thread, &top);
     }
   }
 
+  for (i = 0; i < new_count; i++)
+    mark_subject_threads(ctx, new_hdrs[i], &top);
+
   /* thread by references */
   for (i = 0; i < ctx->msgcount; i++)
   {
@@ -958,7 +1057,7 @@ void mutt_sort_threads(struct Context *ctx, int init)
       new = mutt_hash_find(ctx->thread_hash, ref->data);
       if (!new)
       {
-        new = mutt_mem_calloc(1, sizeof(struct MuttThread));
+        new = mutt_pool_alloc(ctx->thread_pool);
         mutt_hash_insert(ctx->thread_hash, ref->data, new);
       }
       else
@@ -988,10 +1087,20 @@ void mutt_sort_threads(struct Context *ctx, int init)
   }
   ctx->tree = top.child;
 
+  /* the new messages, and anything they were linked to, may now be
+   * pseudo-threaded, too */
+  for (i = 0; i < new_count; i++)
+  {
+    for (thread = new_hdrs[i]->thread; thread->parent; thread = thread->parent)
+      ;
+    thread->check_pseudo = true;
+  }
+  FREE(&new_hdrs);
+
   check_subjects(ctx, init);
 
   if (!option(OPT_STRICT_THREADS))
-    pseudo_threads(ctx);
+    pseudo_threads(ctx, new_only);
 
   if (ctx->tree)
   {
@@ -1385,7 +1494,7 @@ struct Hash *mutt_make_id_hash(struct Context *ctx)
   struct Header *hdr = NULL;
   struct Hash *hash = NULL;
 
-  hash = mutt_hash_create(ctx->msgcount * 2, 0);
+  hash = mutt_hash_create(ctx->msgcount, 0);
 
   for (int i = 0; i < ctx->msgcount; i++)
   {
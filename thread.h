@@ -37,6 +37,7 @@ struct MuttThread
   bool duplicate_thread : 1;
   bool sort_children : 1;
   bool check_subject : 1;
+  bool check_pseudo : 1;
   bool visible : 1;
   bool deep : 1;
   unsigned int subtree_visible : 2;
@@ -213,6 +213,11 @@ static struct CompileOptions comp_opts[] = {
 #else
   { "idn", 0 },
 #endif
+#ifdef USE_INOTIFY
+  { "inotify", 1 },
+#else
+  { "inotify", 0 },
+#endif
 #ifdef LOCALES_HACK
   { "locales_hack", 1 },
 #else
@@ -282,6 +287,11 @@ static struct CompileOptions comp_opts[] = {
   { "typeahead", 1 },
 #else
   { "typeahead", 0 },
+#endif
+#ifdef USE_ZLIB
+  { "zlib", 1 },
+#else
+  { "zlib", 0 },
 #endif
   { NULL, 0 },
 };
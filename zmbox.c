@@ -0,0 +1,1456 @@
+/**
+ * @file
+ * Compressed mailbox archives
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * A zmbox is a mbox in which every message is compressed on its own, as a
+ * separate gzip member.  Members can simply be concatenated, so the file is
+ * still a valid gzip file and `gzip -d` turns it back into a mbox.
+ *
+ * The archive ends with an index of the messages: where each one's member is,
+ * its size, and its header.  The index is stored in the "extra" field of
+ * empty gzip members, which gzip ignores, followed by a fixed-size trailer
+ * that says where the index starts.
+ *
+ *     [msg 1] [msg 2] ... [msg N] [index 1] ... [index M] [trailer]
+ *
+ * So opening an archive only has to read the index, displaying a message only
+ * has to decompress its own member, and appending a message only has to
+ * compress the new one and rewrite the index.
+ *
+ * Every member has an extra subfield with the ID 'N' followed by 'M' for a
+ * message, 'I' for part of the index, or 'T' for the trailer.  If the index is
+ * missing, e.g. because NeoMutt crashed while appending, it's rebuilt by
+ * reading the messages.
+ */
+
+#include "config.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "mutt/mutt.h"
+#include "mutt.h"
+#include "zmbox.h"
+#include "body.h"
+#include "context.h"
+#include "copy.h"
+#include "envelope.h"
+#include "globals.h"
+#include "header.h"
+#include "mailbox.h"
+#include "mutt_curses.h"
+#include "mx.h"
+#include "options.h"
+#include "protos.h"
+#include "rfc822.h"
+#include "sort.h"
+
+#define ZMBOX_CHUNK 16384      /**< data compressed or decompressed at a time */
+#define ZMBOX_EXTRA_MAX 65531  /**< most data in one extra subfield */
+#define ZMBOX_HEAD_SIZE 16     /**< gzip header with one extra subfield */
+#define ZMBOX_TAIL_SIZE 10     /**< empty deflate block, crc and size */
+#define ZMBOX_RECORD_SIZE 32   /**< fixed part of an index record */
+#define ZMBOX_TRAILER_DATA 32  /**< data in the trailer */
+#define ZMBOX_TRAILER_SIZE (ZMBOX_HEAD_SIZE + ZMBOX_TRAILER_DATA + ZMBOX_TAIL_SIZE)
+#define ZMBOX_MAGIC "NMZMBOX1"
+
+/**
+ * struct ZmboxEntry - A message in the index
+ */
+struct ZmboxEntry
+{
+  LOFF_T pos;    /**< offset of the message's gzip member */
+  LOFF_T zlen;   /**< size of the member */
+  LOFF_T len;    /**< size of the message, including the From_ line */
+  int lines;     /**< lines in the body */
+  size_t hdrlen; /**< size of the header, including the blank line */
+  size_t rec;    /**< offset of the message's record in ZmboxIndex::data */
+};
+
+/**
+ * struct ZmboxIndex - The index of an archive
+ *
+ * The index is kept as it's stored, a list of records, each of which is:
+ * pos, zlen, len (8 bytes each), lines, hdrlen (4 bytes each), and the
+ * message's header.  Numbers are little-endian.
+ */
+struct ZmboxIndex
+{
+  unsigned char *data;        /**< the records */
+  size_t len;                 /**< size of the records */
+  size_t max;                 /**< size of the data buffer */
+  struct ZmboxEntry *entries; /**< the records, decoded */
+  int count;                  /**< number of entries */
+  int max_entries;            /**< size of the entries array */
+};
+
+/**
+ * struct ZmboxData - Private data for a zmbox mailbox
+ *
+ * The entries of the index are in the order of the messages, so a Header's
+ * index is also its entry's.
+ */
+struct ZmboxData
+{
+  struct ZmboxIndex index;
+  LOFF_T end;  /**< end of the last message, where the index starts */
+  bool dirty;  /**< the index in the file needs rewriting */
+};
+
+static void put_u16(unsigned char *p, unsigned int n)
+{
+  p[0] = n & 0xff;
+  p[1] = (n >> 8) & 0xff;
+}
+
+static void put_u32(unsigned char *p, uint32_t n)
+{
+  for (int i = 0; i < 4; i++)
+    p[i] = (n >> (8 * i)) & 0xff;
+}
+
+static void put_u64(unsigned char *p, uint64_t n)
+{
+  for (int i = 0; i < 8; i++)
+    p[i] = (n >> (8 * i)) & 0xff;
+}
+
+static unsigned int get_u16(const unsigned char *p)
+{
+  return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_u32(const unsigned char *p)
+{
+  uint32_t n = 0;
+  for (int i = 3; i >= 0; i--)
+    n = (n << 8) | p[i];
+  return n;
+}
+
+static uint64_t get_u64(const unsigned char *p)
+{
+  uint64_t n = 0;
+  for (int i = 7; i >= 0; i--)
+    n = (n << 8) | p[i];
+  return n;
+}
+
+/**
+ * zmbox_tmpfile - Create an anonymous temporary file
+ * @retval ptr  File, open for reading and writing
+ * @retval NULL Error
+ */
+static FILE *zmbox_tmpfile(void)
+{
+  char path[_POSIX_PATH_MAX];
+
+  mutt_mktemp(path, sizeof(path));
+  FILE *fp = mutt_file_fopen(path, "w+");
+  if (!fp)
+  {
+    mutt_perror(path);
+    return NULL;
+  }
+  unlink(path);
+  return fp;
+}
+
+/**
+ * zmbox_is_archive - Is this file a zmbox?
+ * @param fp File to check
+ * @retval true The file starts with a zmbox gzip member
+ */
+bool zmbox_is_archive(FILE *fp)
+{
+  unsigned char head[14];
+
+  if ((fseeko(fp, 0, SEEK_SET) != 0) || (fread(head, 1, sizeof(head), fp) != sizeof(head)))
+    return false;
+
+  return (head[0] == 0x1f) && (head[1] == 0x8b) && (head[2] == 8) &&
+         (head[3] & 0x04) && (head[12] == 'N') &&
+         ((head[13] == 'M') || (head[13] == 'I') || (head[13] == 'T'));
+}
+
+/**
+ * zmbox_index_free - Free the contents of an index
+ * @param idx Index
+ */
+static void zmbox_index_free(struct ZmboxIndex *idx)
+{
+  FREE(&idx->data);
+  FREE(&idx->entries);
+  memset(idx, 0, sizeof(*idx));
+}
+
+/**
+ * zmbox_index_add - Add a message to an index
+ * @param idx    Index
+ * @param pos    Offset of the message's member
+ * @param zlen   Size of the member
+ * @param len    Size of the message
+ * @param lines  Lines in the body
+ * @param hdr    Message's header
+ * @param hdrlen Size of the header
+ */
+static void zmbox_index_add(struct ZmboxIndex *idx, LOFF_T pos, LOFF_T zlen, LOFF_T len,
+                            int lines, const unsigned char *hdr, size_t hdrlen)
+{
+  if (idx->len + ZMBOX_RECORD_SIZE + hdrlen > idx->max)
+  {
+    idx->max = MAX(idx->max * 2, idx->len + ZMBOX_RECORD_SIZE + hdrlen + 4096);
+    mutt_mem_realloc(&idx->data, idx->max);
+  }
+  if (idx->count == idx->max_entries)
+  {
+    idx->max_entries = idx->max_entries ? idx->max_entries * 2 : 64;
+    mutt_mem_realloc(&idx->entries, idx->max_entries * sizeof(struct ZmboxEntry));
+  }
+
+  struct ZmboxEntry *e = &idx->entries[idx->count++];
+  e->pos = pos;
+  e->zlen = zlen;
+  e->len = len;
+  e->lines = lines;
+  e->hdrlen = hdrlen;
+  e->rec = idx->len;
+
+  unsigned char *p = idx->data + idx->len;
+  put_u64(p, pos);
+  put_u64(p + 8, zlen);
+  put_u64(p + 16, len);
+  put_u32(p + 24, lines);
+  put_u32(p + 28, hdrlen);
+  memcpy(p + ZMBOX_RECORD_SIZE, hdr, hdrlen);
+  idx->len += ZMBOX_RECORD_SIZE + hdrlen;
+}
+
+/**
+ * zmbox_index_copy - Copy a message's record to another index
+ * @param dest Index to add to
+ * @param src  Index to copy from
+ * @param n    Number of the entry in src
+ * @param pos  New offset of the message's member
+ */
+static void zmbox_index_copy(struct ZmboxIndex *dest, const struct ZmboxIndex *src,
+                             int n, LOFF_T pos)
+{
+  const struct ZmboxEntry *e = &src->entries[n];
+
+  zmbox_index_add(dest, pos, e->zlen, e->len, e->lines,
+                  src->data + e->rec + ZMBOX_RECORD_SIZE, e->hdrlen);
+}
+
+/**
+ * zmbox_index_parse - Decode the records of an index
+ * @param idx  Index to fill
+ * @param data Records, the index takes ownership of it
+ * @param len  Size of the records
+ * @retval  0 Success
+ * @retval -1 The records are corrupt
+ */
+static int zmbox_index_parse(struct ZmboxIndex *idx, unsigned char *data, size_t len)
+{
+  size_t off = 0;
+
+  zmbox_index_free(idx);
+
+  while (off < len)
+  {
+    if (len - off < ZMBOX_RECORD_SIZE)
+      goto bad;
+
+    const unsigned char *p = data + off;
+    size_t hdrlen = get_u32(p + 28);
+    if (len - off - ZMBOX_RECORD_SIZE < hdrlen)
+      goto bad;
+
+    zmbox_index_add(idx, get_u64(p), get_u64(p + 8), get_u64(p + 16),
+                    get_u32(p + 24), p + ZMBOX_RECORD_SIZE, hdrlen);
+    off += ZMBOX_RECORD_SIZE + hdrlen;
+  }
+
+  FREE(&data);
+  return 0;
+
+bad:
+  FREE(&data);
+  zmbox_index_free(idx);
+  return -1;
+}
+
+/**
+ * zmbox_write_member - Compress a message into a new gzip member
+ * @param fpin  Message to compress, read from the current position
+ * @param fpout File to write the member to
+ * @param zlen  Size of the member
+ * @retval  0 Success
+ * @retval -1 Error
+ */
+static int zmbox_write_member(FILE *fpin, FILE *fpout, LOFF_T *zlen)
+{
+  unsigned char in[ZMBOX_CHUNK];
+  unsigned char out[ZMBOX_CHUNK];
+  unsigned char extra[4] = { 'N', 'M', 0, 0 };
+  gz_header head;
+  z_stream strm;
+  int flush;
+
+  *zlen = 0;
+  memset(&head, 0, sizeof(head));
+  memset(&strm, 0, sizeof(strm));
+  if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 31, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    return -1;
+
+  head.extra = extra;
+  head.extra_len = sizeof(extra);
+  head.os = 3; /* Unix */
+  deflateSetHeader(&strm, &head);
+
+  do
+  {
+    strm.avail_in = fread(in, 1, sizeof(in), fpin);
+    if (ferror(fpin))
+      goto fail;
+    strm.next_in = in;
+    flush = feof(fpin) ? Z_FINISH : Z_NO_FLUSH;
+
+    do
+    {
+      strm.next_out = out;
+      strm.avail_out = sizeof(out);
+      if (deflate(&strm, flush) == Z_STREAM_ERROR)
+        goto fail;
+
+      size_t have = sizeof(out) - strm.avail_out;
+      if (fwrite(out, 1, have, fpout) != have)
+        goto fail;
+      *zlen += have;
+    } while (strm.avail_out == 0);
+  } while (flush != Z_FINISH);
+
+  deflateEnd(&strm);
+  return 0;
+
+fail:
+  deflateEnd(&strm);
+  return -1;
+}
+
+/**
+ * zmbox_read_member - Decompress a gzip member
+ * @param fpin  Archive
+ * @param pos   Offset of the member
+ * @param fpout File to write the data to, may be NULL
+ * @param zlen  Size of the member
+ * @param head  If not NULL, the member's gzip header is saved here
+ * @retval  0 Success
+ * @retval -1 Error, e.g. the member is corrupt or incomplete
+ */
+static int zmbox_read_member(FILE *fpin, LOFF_T pos, FILE *fpout, LOFF_T *zlen, gz_header *head)
+{
+  unsigned char in[ZMBOX_CHUNK];
+  unsigned char out[ZMBOX_CHUNK];
+  z_stream strm;
+  LOFF_T used = 0;
+  int zrc = Z_OK;
+
+  *zlen = 0;
+  if (fseeko(fpin, pos, SEEK_SET) != 0)
+    return -1;
+
+  memset(&strm, 0, sizeof(strm));
+  if (inflateInit2(&strm, 31) != Z_OK)
+    return -1;
+  if (head)
+    inflateGetHeader(&strm, head);
+
+  while (zrc != Z_STREAM_END)
+  {
+    if (strm.avail_in == 0)
+    {
+      strm.avail_in = fread(in, 1, sizeof(in), fpin);
+      if (strm.avail_in == 0)
+        break;
+      strm.next_in = in;
+      used += strm.avail_in;
+    }
+
+    strm.next_out = out;
+    strm.avail_out = sizeof(out);
+    zrc = inflate(&strm, Z_NO_FLUSH);
+    if ((zrc != Z_OK) && (zrc != Z_STREAM_END))
+      break;
+
+    size_t have = sizeof(out) - strm.avail_out;
+    if (fpout && (fwrite(out, 1, have, fpout) != have))
+    {
+      zrc = Z_ERRNO;
+      break;
+    }
+  }
+
+  *zlen = used - strm.avail_in;
+  inflateEnd(&strm);
+  return (zrc == Z_STREAM_END) ? 0 : -1;
+}
+
+/**
+ * zmbox_index_message - Add a decompressed message to an index
+ * @param idx  Index
+ * @param fp   Message, starting with its From_ line
+ * @param pos  Offset of the message's member
+ * @param zlen Size of the member
+ * @retval  0 Success
+ * @retval -1 Error, or the file isn't a message
+ *
+ * The message ends with the blank line that separates mbox messages.
+ */
+static int zmbox_index_message(struct ZmboxIndex *idx, FILE *fp, LOFF_T pos, LOFF_T zlen)
+{
+  char from[5];
+  LOFF_T len = 0;
+  LOFF_T hdrlen = -1;
+  int lines = 0;
+  int c, prev = 0;
+
+  if ((fseeko(fp, 0, SEEK_SET) != 0) || (fread(from, 1, sizeof(from), fp) != sizeof(from)) ||
+      (strncmp(from, "From ", sizeof(from)) != 0))
+  {
+    return -1;
+  }
+  len = sizeof(from);
+
+  /* find the end of the header and count the lines of the body */
+  while ((c = getc(fp)) != EOF)
+  {
+    len++;
+    if (c == '\n')
+    {
+      if (hdrlen >= 0)
+        lines++;
+      else if (prev == '\n')
+        hdrlen = len;
+    }
+    prev = c;
+  }
+  if (ferror(fp))
+    return -1;
+
+  if (hdrlen < 0)
+    hdrlen = len;
+  /* don't count the separator */
+  if (lines > 0)
+    lines--;
+
+  unsigned char *hdr = mutt_mem_malloc(hdrlen);
+  if ((fseeko(fp, 0, SEEK_SET) != 0) || (fread(hdr, 1, hdrlen, fp) != (size_t) hdrlen))
+  {
+    FREE(&hdr);
+    return -1;
+  }
+
+  zmbox_index_add(idx, pos, zlen, len, lines, hdr, hdrlen);
+  FREE(&hdr);
+  return 0;
+}
+
+/**
+ * zmbox_write_extra - Write an empty gzip member carrying some data
+ * @param fp   File to write to
+ * @param id   Second byte of the subfield ID, e.g. 'I'
+ * @param data Data to store in the extra field
+ * @param len  Size of the data, at most #ZMBOX_EXTRA_MAX
+ * @retval  0 Success
+ * @retval -1 Error
+ */
+static int zmbox_write_extra(FILE *fp, char id, const unsigned char *data, size_t len)
+{
+  /* an empty final deflate block, and the crc and size of no data */
+  static const unsigned char tail[ZMBOX_TAIL_SIZE] = { 0x03 };
+  unsigned char head[ZMBOX_HEAD_SIZE] = { 0x1f, 0x8b, 8, 0x04, 0, 0, 0, 0, 0, 3 };
+
+  put_u16(head + 10, len + 4);
+  head[12] = 'N';
+  head[13] = id;
+  put_u16(head + 14, len);
+
+  if ((fwrite(head, 1, sizeof(head), fp) != sizeof(head)) ||
+      (fwrite(data, 1, len, fp) != len) || (fwrite(tail, 1, sizeof(tail), fp) != sizeof(tail)))
+  {
+    return -1;
+  }
+
+  return 0;
+}
+
+/**
+ * zmbox_check_extra - Check the header of a member written by zmbox_write_extra()
+ * @param head Start of the member
+ * @param id   Expected subfield ID
+ * @param len  Expected size of the data
+ * @retval true The header is valid
+ */
+static bool zmbox_check_extra(const unsigned char *head, char id, size_t len)
+{
+  return (head[0] == 0x1f) && (head[1] == 0x8b) && (head[2] == 8) &&
+         (head[3] == 0x04) && (get_u16(head + 10) == len + 4) &&
+         (head[12] == 'N') && (head[13] == id) && (get_u16(head + 14) == len);
+}
+
+/**
+ * zmbox_write_index - Write the index and trailer of an archive
+ * @param idx Index
+ * @param fp  File to write to
+ * @param pos Offset in the archive that the index is being written at
+ * @retval  0 Success
+ * @retval -1 Error
+ */
+static int zmbox_write_index(const struct ZmboxIndex *idx, FILE *fp, LOFF_T pos)
+{
+  unsigned char trailer[ZMBOX_TRAILER_DATA];
+  unsigned char *zbuf = NULL;
+  uLongf zlen = 0;
+  int rc = -1;
+
+  if (idx->len > 0)
+  {
+    zlen = compressBound(idx->len);
+    zbuf = mutt_mem_malloc(zlen);
+    if (compress2(zbuf, &zlen, idx->data, idx->len, Z_BEST_COMPRESSION) != Z_OK)
+      goto done;
+  }
+
+  for (uLongf off = 0; off < zlen; off += ZMBOX_EXTRA_MAX)
+  {
+    if (zmbox_write_extra(fp, 'I', zbuf + off, MIN(zlen - off, ZMBOX_EXTRA_MAX)) != 0)
+      goto done;
+  }
+
+  memcpy(trailer, ZMBOX_MAGIC, 8);
+  put_u64(trailer + 8, pos);
+  put_u64(trailer + 16, idx->len);
+  put_u64(trailer + 24, zlen);
+  rc = zmbox_write_extra(fp, 'T', trailer, sizeof(trailer));
+
+done:
+  FREE(&zbuf);
+  return rc;
+}
+
+/**
+ * zmbox_read_index - Read the index of an archive
+ * @param fp   Archive
+ * @param size Size of the archive
+ * @param idx  Index to fill
+ * @param end  Offset of the start of the index
+ * @retval  0 Success
+ * @retval -1 The index is missing or corrupt
+ */
+static int zmbox_read_index(FILE *fp, LOFF_T size, struct ZmboxIndex *idx, LOFF_T *end)
+{
+  unsigned char buf[ZMBOX_TRAILER_SIZE];
+  unsigned char *zbuf = NULL;
+  unsigned char *data = NULL;
+
+  if ((size < ZMBOX_TRAILER_SIZE) || (fseeko(fp, size - ZMBOX_TRAILER_SIZE, SEEK_SET) != 0) ||
+      (fread(buf, 1, sizeof(buf), fp) != sizeof(buf)) ||
+      !zmbox_check_extra(buf, 'T', ZMBOX_TRAILER_DATA) ||
+      (memcmp(buf + ZMBOX_HEAD_SIZE, ZMBOX_MAGIC, 8) != 0))
+  {
+    return -1;
+  }
+
+  uint64_t pos = get_u64(buf + ZMBOX_HEAD_SIZE + 8);
+  uint64_t len = get_u64(buf + ZMBOX_HEAD_SIZE + 16);
+  uint64_t zlen = get_u64(buf + ZMBOX_HEAD_SIZE + 24);
+
+  /* the index must exactly fill the space before the trailer */
+  uint64_t chunks = (zlen + ZMBOX_EXTRA_MAX - 1) / ZMBOX_EXTRA_MAX;
+  if ((pos > (uint64_t) size) || (size - ZMBOX_TRAILER_SIZE - pos !=
+                                  zlen + chunks * (ZMBOX_HEAD_SIZE + ZMBOX_TAIL_SIZE)))
+  {
+    return -1;
+  }
+  /* deflate can't do better than about 1000:1 */
+  if ((len > zlen * 1100 + 1024) || (fseeko(fp, pos, SEEK_SET) != 0))
+    return -1;
+
+  zbuf = mutt_mem_malloc(zlen + 1);
+  for (uint64_t off = 0; off < zlen; off += ZMBOX_EXTRA_MAX)
+  {
+    size_t n = MIN(zlen - off, ZMBOX_EXTRA_MAX);
+    if ((fread(buf, 1, ZMBOX_HEAD_SIZE, fp) != ZMBOX_HEAD_SIZE) ||
+        !zmbox_check_extra(buf, 'I', n) || (fread(zbuf + off, 1, n, fp) != n) ||
+        (fread(buf, 1, ZMBOX_TAIL_SIZE, fp) != ZMBOX_TAIL_SIZE))
+    {
+      goto fail;
+    }
+  }
+
+  data = mutt_mem_malloc(len + 1);
+  uLongf dlen = len;
+  if ((len > 0) && ((uncompress(data, &dlen, zbuf, zlen) != Z_OK) || (dlen != len)))
+    goto fail;
+
+  FREE(&zbuf);
+  *end = pos;
+  return zmbox_index_parse(idx, data, len);
+
+fail:
+  FREE(&zbuf);
+  FREE(&data);
+  return -1;
+}
+
+/**
+ * zmbox_scan - Rebuild the index of an archive by reading its messages
+ * @param ctx Mailbox
+ * @param idx Index to fill
+ * @param end Offset of the end of the last message
+ * @retval  0 Success
+ * @retval -1 Error
+ * @retval -2 Aborted by the user
+ *
+ * The scan stops at the first member that can't be read, e.g. a message that
+ * was only partly written.
+ */
+static int zmbox_scan(struct Context *ctx, struct ZmboxIndex *idx, LOFF_T *end)
+{
+  struct Progress progress;
+  char msgbuf[STRING];
+  unsigned char extra[16];
+  gz_header head;
+  LOFF_T pos = 0, zlen;
+
+  FILE *fp = zmbox_tmpfile();
+  if (!fp)
+    return -1;
+
+  if (!ctx->quiet)
+  {
+    snprintf(msgbuf, sizeof(msgbuf), _("Rebuilding the index of %s..."), ctx->path);
+    mutt_progress_init(&progress, msgbuf, MUTT_PROGRESS_SIZE, ReadInc, ctx->size);
+  }
+
+  zmbox_index_free(idx);
+  *end = 0;
+
+  while ((pos < ctx->size) && (SigInt != 1))
+  {
+    memset(&head, 0, sizeof(head));
+    head.extra = extra;
+    head.extra_max = sizeof(extra);
+
+    if ((fseeko(fp, 0, SEEK_SET) != 0) || (ftruncate(fileno(fp), 0) != 0) ||
+        (zmbox_read_member(ctx->fp, pos, fp, &zlen, &head) != 0) || (fflush(fp) != 0))
+    {
+      mutt_debug(1, "zmbox_scan: bad member at " OFF_T_FMT "\n", pos);
+      break;
+    }
+
+    if ((head.extra_len >= 4) && (extra[0] == 'N') && (extra[1] == 'M'))
+    {
+      if (zmbox_index_message(idx, fp, pos, zlen) != 0)
+        break;
+      *end = pos + zlen;
+    }
+
+    pos += zlen;
+    if (!ctx->quiet)
+      mutt_progress_update(&progress, pos, -1);
+  }
+
+  mutt_file_fclose(&fp);
+
+  if (SigInt == 1)
+  {
+    SigInt = 0;
+    zmbox_index_free(idx);
+    return -2;
+  }
+
+  return 0;
+}
+
+/**
+ * zmbox_add_headers - Create the Headers of messages in the index
+ * @param ctx   Mailbox
+ * @param first First entry of the index to create a Header for
+ * @retval  0 Success
+ * @retval -1 Error
+ *
+ * The messages' headers are copied into a temporary file, so that they can be
+ * parsed without decompressing the messages.
+ */
+static int zmbox_add_headers(struct Context *ctx, int first)
+{
+  struct ZmboxData *zd = ctx->data;
+  struct ZmboxIndex *idx = &zd->index;
+  char buf[HUGE_STRING], return_path[STRING];
+  struct Progress progress;
+  char msgbuf[STRING];
+  LOFF_T start = 0;
+  int added = 0;
+  time_t t;
+
+  if (first >= idx->count)
+    return 0;
+
+  FILE *fp = zmbox_tmpfile();
+  if (!fp)
+    return -1;
+
+  for (int i = first; i < idx->count; i++)
+  {
+    struct ZmboxEntry *e = &idx->entries[i];
+    if (fwrite(idx->data + e->rec + ZMBOX_RECORD_SIZE, 1, e->hdrlen, fp) != e->hdrlen)
+    {
+      mutt_file_fclose(&fp);
+      return -1;
+    }
+  }
+
+  if (!ctx->quiet)
+  {
+    snprintf(msgbuf, sizeof(msgbuf), _("Reading %s..."), ctx->path);
+    mutt_progress_init(&progress, msgbuf, MUTT_PROGRESS_MSG, ReadInc, idx->count - first);
+  }
+
+  for (int i = first; i < idx->count; i++)
+  {
+    struct ZmboxEntry *e = &idx->entries[i];
+
+    if (!ctx->quiet)
+      mutt_progress_update(&progress, i - first + 1, -1);
+
+    if ((fseeko(fp, start, SEEK_SET) != 0) || !fgets(buf, sizeof(buf), fp))
+      break;
+
+    return_path[0] = '\0';
+    if (!is_from(buf, return_path, sizeof(return_path), &t))
+      t = 0;
+
+    if (ctx->msgcount == ctx->hdrmax)
+      mx_alloc_memory(ctx);
+
+    struct Header *h = ctx->hdrs[ctx->msgcount] = mutt_new_pooled_header(ctx->hdr_pool);
+    h->received = t - mutt_date_local_tz(t);
+    h->index = ctx->msgcount;
+    h->offset = start;
+    h->env = mutt_read_rfc822_header(fp, h, 0, 0);
+
+    /* the message is read from its own file, starting with the From_ line */
+    h->offset = 0;
+    h->content->hdr_offset = 0;
+    h->content->offset = e->hdrlen;
+    h->content->length = MAX(e->len - (LOFF_T) e->hdrlen - 1, 0);
+    h->lines = e->lines;
+
+    if (!h->env->return_path && return_path[0])
+      h->env->return_path = rfc822_parse_adrlist(h->env->return_path, return_path);
+
+    if (!h->env->from)
+      h->env->from = rfc822_cpy_adr(h->env->return_path, 0);
+
+    ctx->msgcount++;
+    added++;
+    start += e->hdrlen;
+  }
+
+  mutt_file_fclose(&fp);
+  if (added > 0)
+    mx_update_context(ctx, added);
+  return (added == idx->count - first) ? 0 : -1;
+}
+
+/**
+ * zmbox_parse_mailbox - Read the index of an archive
+ * @param ctx Mailbox
+ * @retval  0 Success
+ * @retval -1 Error
+ * @retval -2 Aborted by the user
+ */
+static int zmbox_parse_mailbox(struct Context *ctx)
+{
+  struct ZmboxData *zd = ctx->data;
+  struct stat sb;
+
+  if (fstat(fileno(ctx->fp), &sb) == -1)
+  {
+    mutt_perror(ctx->path);
+    return -1;
+  }
+  ctx->size = sb.st_size;
+  ctx->mtime = sb.st_mtime;
+  ctx->atime = sb.st_atime;
+
+  if (!ctx->readonly)
+    ctx->readonly = access(ctx->path, W_OK) ? true : false;
+
+  zmbox_index_free(&zd->index);
+  zd->end = 0;
+  zd->dirty = false;
+
+  if (ctx->size == 0)
+    return 0;
+
+  if (zmbox_read_index(ctx->fp, ctx->size, &zd->index, &zd->end) != 0)
+  {
+    mutt_debug(1, "zmbox_parse_mailbox: no index in %s\n", ctx->path);
+    int rc = zmbox_scan(ctx, &zd->index, &zd->end);
+    if (rc != 0)
+      return rc;
+    zd->dirty = true;
+  }
+
+  return zmbox_add_headers(ctx, 0);
+}
+
+/**
+ * zmbox_lock_mailbox - Lock a mailbox
+ * @param ctx   Mailbox
+ * @param excl  Exclusive lock?
+ * @param retry Should retry if unable to lock?
+ * @retval  0 Success
+ * @retval -1 Failure
+ */
+static int zmbox_lock_mailbox(struct Context *ctx, int excl, int retry)
+{
+  int r = mutt_file_lock(ctx->path, fileno(ctx->fp), excl, retry);
+  if (r == 0)
+    ctx->locked = true;
+  else if (retry && !excl)
+  {
+    ctx->readonly = true;
+    return 0;
+  }
+
+  return r;
+}
+
+static void zmbox_unlock_mailbox(struct Context *ctx)
+{
+  if (ctx->locked)
+  {
+    fflush(ctx->fp);
+    mutt_file_unlock(ctx->path, fileno(ctx->fp));
+    ctx->locked = false;
+  }
+}
+
+/**
+ * zmbox_write_tail - Write the index at the end of the messages
+ * @param ctx Mailbox, locked and open for writing
+ * @retval  0 Success
+ * @retval -1 Error
+ */
+static int zmbox_write_tail(struct Context *ctx)
+{
+  struct ZmboxData *zd = ctx->data;
+
+  if ((fflush(ctx->fp) != 0) || (ftruncate(fileno(ctx->fp), zd->end) != 0) ||
+      (fseeko(ctx->fp, zd->end, SEEK_SET) != 0) ||
+      (zmbox_write_index(&zd->index, ctx->fp, zd->end) != 0) ||
+      (fflush(ctx->fp) != 0) || (fsync(fileno(ctx->fp)) == -1))
+  {
+    mutt_perror(ctx->path);
+    return -1;
+  }
+
+  zd->dirty = false;
+  return 0;
+}
+
+/**
+ * zmbox_reread_mailbox - Read an archive again, from scratch
+ * @param ctx Mailbox, with no messages
+ * @retval  0 Success
+ * @retval -1 Error
+ *
+ * This is used by mbox_reopen_mailbox() when the archive has been rewritten.
+ */
+int zmbox_reread_mailbox(struct Context *ctx)
+{
+  mutt_file_fclose(&ctx->fp);
+  ctx->fp = mutt_file_fopen(ctx->path, "r");
+  if (!ctx->fp)
+    return -1;
+
+  return zmbox_parse_mailbox(ctx);
+}
+
+static int zmbox_open_mailbox(struct Context *ctx)
+{
+  ctx->fp = fopen(ctx->path, "r");
+  if (!ctx->fp)
+  {
+    mutt_perror(ctx->path);
+    return -1;
+  }
+
+  ctx->data = mutt_mem_calloc(1, sizeof(struct ZmboxData));
+
+  mutt_block_signals();
+  if (zmbox_lock_mailbox(ctx, 0, 1) == -1)
+  {
+    mutt_unblock_signals();
+    return -1;
+  }
+
+  int rc = zmbox_parse_mailbox(ctx);
+  mutt_file_touch_atime(fileno(ctx->fp));
+
+  zmbox_unlock_mailbox(ctx);
+  mutt_unblock_signals();
+  return rc;
+}
+
+static int zmbox_open_mailbox_append(struct Context *ctx, int flags)
+{
+  struct stat sb;
+
+  ctx->fp = mutt_file_fopen(ctx->path, (flags & MUTT_NEWFOLDER) ? "w+" : "a+");
+  if (!ctx->fp)
+  {
+    mutt_perror(ctx->path);
+    return -1;
+  }
+
+  if (zmbox_lock_mailbox(ctx, 1, 1) != 0)
+  {
+    mutt_error(_("Couldn't lock %s\n"), ctx->path);
+    mutt_file_fclose(&ctx->fp);
+    return -1;
+  }
+
+  struct ZmboxData *zd = mutt_mem_calloc(1, sizeof(struct ZmboxData));
+  ctx->data = zd;
+  zd->dirty = true;
+
+  if (fstat(fileno(ctx->fp), &sb) == -1)
+  {
+    mutt_perror(ctx->path);
+    goto fail;
+  }
+  ctx->size = sb.st_size;
+
+  if ((ctx->size > 0) && (zmbox_read_index(ctx->fp, ctx->size, &zd->index, &zd->end) != 0) &&
+      (zmbox_scan(ctx, &zd->index, &zd->end) != 0))
+  {
+    goto fail;
+  }
+
+  /* the new messages replace the index */
+  if ((ftruncate(fileno(ctx->fp), zd->end) != 0) || (fseeko(ctx->fp, 0, SEEK_END) != 0))
+  {
+    mutt_perror(ctx->path);
+    goto fail;
+  }
+
+  return 0;
+
+fail:
+  zmbox_unlock_mailbox(ctx);
+  mutt_file_fclose(&ctx->fp);
+  zmbox_index_free(&zd->index);
+  FREE(&ctx->data);
+  return -1;
+}
+
+static int zmbox_close_mailbox(struct Context *ctx)
+{
+  struct ZmboxData *zd = ctx->data;
+  int rc = 0;
+
+  if (zd && ctx->fp)
+  {
+    if (ctx->append)
+    {
+      /* the old index was cut off when the archive was opened */
+      if (zmbox_write_tail(ctx) != 0)
+      {
+        mutt_error(_("Couldn't write the index of %s"), ctx->path);
+        rc = -1;
+      }
+      zmbox_unlock_mailbox(ctx);
+    }
+    else if (zd->dirty && !ctx->readonly)
+    {
+      /* save the index that was rebuilt when the archive was opened */
+      ctx->fp = freopen(ctx->path, "r+", ctx->fp);
+      if (!ctx->fp)
+      {
+        mutt_perror(ctx->path);
+        rc = -1;
+      }
+      else if (zmbox_lock_mailbox(ctx, 1, 1) == 0)
+      {
+        if (zmbox_write_tail(ctx) != 0)
+          rc = -1;
+        zmbox_unlock_mailbox(ctx);
+      }
+    }
+  }
+
+  if (zd)
+  {
+    zmbox_index_free(&zd->index);
+    FREE(&ctx->data);
+  }
+
+  mutt_file_fclose(&ctx->fp);
+  return rc;
+}
+
+/**
+ * zmbox_check_mailbox - Has the archive changed on disk
+ * @param[in]  ctx        Mailbox
+ * @param[out] index_hint Keep track of current index selection
+ * @retval #MUTT_REOPENED  Mailbox has been reopened
+ * @retval #MUTT_NEW_MAIL  New mail has arrived
+ * @retval #MUTT_LOCKED    Couldn't lock the file
+ * @retval 0               No change
+ * @retval -1              Error
+ *
+ * If messages have only been appended, the index starts with the old one.
+ * Otherwise the archive has been rewritten, so it's reopened.
+ */
+static int zmbox_check_mailbox(struct Context *ctx, int *index_hint)
+{
+  struct ZmboxData *zd = ctx->data;
+  struct ZmboxIndex idx = { 0 };
+  struct stat st;
+  bool unlock = false;
+  LOFF_T end = 0;
+  int rc = -1;
+
+  if (stat(ctx->path, &st) != 0)
+    goto bail;
+
+  if ((st.st_mtime == ctx->mtime) && (st.st_size == ctx->size))
+    return 0;
+
+  if (!ctx->locked)
+  {
+    mutt_block_signals();
+    if (zmbox_lock_mailbox(ctx, 0, 0) == -1)
+    {
+      mutt_unblock_signals();
+      return MUTT_LOCKED;
+    }
+    unlock = true;
+  }
+
+  if ((zmbox_read_index(ctx->fp, st.st_size, &idx, &end) == 0) &&
+      (idx.count >= zd->index.count))
+  {
+    int i;
+    for (i = 0; i < zd->index.count; i++)
+    {
+      if ((idx.entries[i].pos != zd->index.entries[i].pos) ||
+          (idx.entries[i].zlen != zd->index.entries[i].zlen))
+        break;
+    }
+
+    if (i == zd->index.count)
+    {
+      int first = zd->index.count;
+
+      zmbox_index_free(&zd->index);
+      zd->index = idx;
+      zd->end = end;
+      ctx->size = st.st_size;
+      ctx->mtime = st.st_mtime;
+      zmbox_add_headers(ctx, first);
+      rc = (idx.count > first) ? MUTT_NEW_MAIL : 0;
+      goto done;
+    }
+  }
+
+  zmbox_index_free(&idx);
+  if (mbox_reopen_mailbox(ctx, index_hint) != -1)
+    rc = MUTT_REOPENED;
+
+done:
+  if (unlock)
+  {
+    zmbox_unlock_mailbox(ctx);
+    mutt_unblock_signals();
+  }
+
+bail:
+  if (rc == -1)
+    mutt_error(_("Mailbox was corrupted!"));
+  return rc;
+}
+
+static int zmbox_open_message(struct Context *ctx, struct Message *msg, int msgno)
+{
+  struct ZmboxData *zd = ctx->data;
+  struct Header *h = ctx->hdrs[msgno];
+  LOFF_T zlen;
+
+  if (!zd || (h->index < 0) || (h->index >= zd->index.count))
+    return -1;
+
+  msg->fp = zmbox_tmpfile();
+  if (!msg->fp)
+    return -1;
+
+  if ((zmbox_read_member(ctx->fp, zd->index.entries[h->index].pos, msg->fp, &zlen, NULL) != 0) ||
+      (fflush(msg->fp) != 0) || (fseeko(msg->fp, 0, SEEK_SET) != 0))
+  {
+    mutt_error(_("Can't read message %d from %s"), msgno + 1, ctx->path);
+    mutt_file_fclose(&msg->fp);
+    return -1;
+  }
+
+  return 0;
+}
+
+static int zmbox_close_message(struct Context *ctx, struct Message *msg)
+{
+  return mutt_file_fclose(&msg->fp);
+}
+
+static int zmbox_open_new_message(struct Message *msg, struct Context *dest, struct Header *hdr)
+{
+  msg->fp = zmbox_tmpfile();
+  return msg->fp ? 0 : -1;
+}
+
+static int zmbox_commit_message(struct Context *ctx, struct Message *msg)
+{
+  struct ZmboxData *zd = ctx->data;
+  LOFF_T zlen;
+
+  if ((fputc('\n', msg->fp) == EOF) || (fflush(msg->fp) != 0) ||
+      (fseeko(msg->fp, 0, SEEK_SET) != 0))
+  {
+    return -1;
+  }
+
+  if ((fseeko(ctx->fp, zd->end, SEEK_SET) != 0) ||
+      (zmbox_write_member(msg->fp, ctx->fp, &zlen) != 0) ||
+      (fflush(ctx->fp) == EOF) || (fsync(fileno(ctx->fp)) == -1))
+  {
+    mutt_perror(_("Can't write message"));
+    return -1;
+  }
+
+  if (zmbox_index_message(&zd->index, msg->fp, zd->end, zlen) != 0)
+    return -1;
+
+  zd->end += zlen;
+  return 0;
+}
+
+/**
+ * zmbox_copy_member - Copy a message's member without decompressing it
+ * @param fpin  Archive
+ * @param e     Message to copy
+ * @param fpout File to write to
+ * @retval  0 Success
+ * @retval -1 Error
+ */
+static int zmbox_copy_member(FILE *fpin, const struct ZmboxEntry *e, FILE *fpout)
+{
+  char buf[ZMBOX_CHUNK];
+  LOFF_T left = e->zlen;
+
+  if (fseeko(fpin, e->pos, SEEK_SET) != 0)
+    return -1;
+
+  while (left > 0)
+  {
+    size_t n = fread(buf, 1, MIN(left, (LOFF_T) sizeof(buf)), fpin);
+    if ((n == 0) || (fwrite(buf, 1, n, fpout) != n))
+      return -1;
+    left -= n;
+  }
+
+  return 0;
+}
+
+/**
+ * zmbox_sync_mailbox - Save changes to the archive
+ * @param[in]  ctx        Mailbox
+ * @param[out] index_hint Keep track of current index selection
+ * @retval  0 Success
+ * @retval -1 Failure
+ *
+ * Like a mbox, the archive is rewritten from the first changed message.
+ * Unchanged messages are copied without being decompressed.
+ */
+static int zmbox_sync_mailbox(struct Context *ctx, int *index_hint)
+{
+  struct ZmboxData *zd = ctx->data;
+  struct ZmboxIndex idx = { 0 };
+  char tempfile[_POSIX_PATH_MAX];
+  FILE *fp = NULL, *msgfp = NULL;
+  struct Progress progress;
+  char msgbuf[STRING];
+  struct stat statbuf;
+  int i, j, first, save_sort;
+  int rc = -1;
+  int need_sort = 0;
+  LOFF_T offset, zlen;
+
+  /* sort message by their position in the mailbox on disk */
+  if (Sort != SORT_ORDER)
+  {
+    save_sort = Sort;
+    Sort = SORT_ORDER;
+    mutt_sort_headers(ctx, 0);
+    Sort = save_sort;
+    need_sort = 1;
+  }
+
+  ctx->fp = freopen(ctx->path, "r+", ctx->fp);
+  if (!ctx->fp)
+  {
+    mx_fastclose_mailbox(ctx);
+    mutt_error(_("Fatal error!  Could not reopen mailbox!"));
+    return -1;
+  }
+
+  mutt_block_signals();
+
+  if (zmbox_lock_mailbox(ctx, 1, 1) == -1)
+  {
+    mutt_unblock_signals();
+    mutt_error(_("Unable to lock mailbox!"));
+    goto bail;
+  }
+
+  /* Check to make sure that the file hasn't changed on disk */
+  i = zmbox_check_mailbox(ctx, index_hint);
+  if ((i == MUTT_NEW_MAIL) || (i == MUTT_REOPENED))
+  {
+    need_sort = i;
+    rc = i;
+    goto bail;
+  }
+  else if (i < 0)
+    goto bail;
+
+  for (first = 0; (first < ctx->msgcount) && !ctx->hdrs[first]->deleted &&
+                  !ctx->hdrs[first]->changed && !ctx->hdrs[first]->attach_del;
+       first++)
+    ;
+
+  offset = (first < ctx->msgcount) ? zd->index.entries[ctx->hdrs[first]->index].pos : zd->end;
+
+  mutt_mktemp(tempfile, sizeof(tempfile));
+  if ((i = open(tempfile, O_RDWR | O_EXCL | O_CREAT, 0600)) == -1 ||
+      (fp = fdopen(i, "w+")) == NULL)
+  {
+    if (i != -1)
+    {
+      close(i);
+      unlink(tempfile);
+    }
+    mutt_error(_("Could not create temporary file!"));
+    mutt_sleep(5);
+    goto bail;
+  }
+
+  if (!ctx->quiet)
+  {
+    snprintf(msgbuf, sizeof(msgbuf), _("Writing %s..."), ctx->path);
+    mutt_progress_init(&progress, msgbuf, MUTT_PROGRESS_MSG, WriteInc, ctx->msgcount);
+  }
+
+  for (i = 0; i < first; i++)
+    zmbox_index_copy(&idx, &zd->index, ctx->hdrs[i]->index,
+                     zd->index.entries[ctx->hdrs[i]->index].pos);
+
+  for (i = first; i < ctx->msgcount; i++)
+  {
+    struct Header *h = ctx->hdrs[i];
+
+    if (!ctx->quiet)
+      mutt_progress_update(&progress, i, -1);
+
+    if (h->deleted)
+      continue;
+
+    LOFF_T pos = offset + ftello(fp);
+
+    if (h->changed || h->attach_del)
+    {
+      /* the header has changed, so the message has to be recompressed */
+      msgfp = zmbox_tmpfile();
+      if (!msgfp ||
+          (mutt_copy_message_ctx(msgfp, ctx, h, MUTT_CM_UPDATE, CH_FROM | CH_UPDATE | CH_UPDATE_LEN) != 0) ||
+          (fputc('\n', msgfp) == EOF) || (fflush(msgfp) != 0) ||
+          (fseeko(msgfp, 0, SEEK_SET) != 0) || (zmbox_write_member(msgfp, fp, &zlen) != 0) ||
+          (zmbox_index_message(&idx, msgfp, pos, zlen) != 0))
+      {
+        mutt_perror(tempfile);
+        mutt_sleep(5);
+        goto bail;
+      }
+      mutt_file_fclose(&msgfp);
+      mutt_free_body(&h->content->parts);
+    }
+    else
+    {
+      if (zmbox_copy_member(ctx->fp, &zd->index.entries[h->index], fp) != 0)
+      {
+        mutt_perror(tempfile);
+        mutt_sleep(5);
+        goto bail;
+      }
+      zmbox_index_copy(&idx, &zd->index, h->index, pos);
+    }
+  }
+
+  LOFF_T end = offset + ftello(fp);
+  if (((idx.count > 0) && (zmbox_write_index(&idx, fp, end) != 0)) || (fflush(fp) != 0))
+  {
+    mutt_perror(tempfile);
+    mutt_sleep(5);
+    goto bail;
+  }
+
+  /* Save the state of this folder. */
+  if (stat(ctx->path, &statbuf) == -1)
+  {
+    mutt_perror(ctx->path);
+    mutt_sleep(5);
+    goto bail;
+  }
+
+  /* copy the new end of the archive into place */
+  if (!ctx->quiet)
+    mutt_message(_("Committing changes..."));
+  if ((fseeko(fp, 0, SEEK_SET) != 0) || (fseeko(ctx->fp, offset, SEEK_SET) != 0) ||
+      (mutt_file_copy_stream(fp, ctx->fp) != 0) || (fflush(ctx->fp) != 0) ||
+      (ftruncate(fileno(ctx->fp), (idx.count > 0) ? ftello(ctx->fp) : 0) != 0) ||
+      (fsync(fileno(ctx->fp)) == -1))
+  {
+    /* keep the new end of the archive, it can be appended by hand */
+    char savefile[_POSIX_PATH_MAX];
+
+    mutt_file_fclose(&fp);
+    snprintf(savefile, sizeof(savefile), "%s/mutt.%s-%s-%u", NONULL(Tmpdir),
+             NONULL(Username), NONULL(ShortHostname), (unsigned int) getpid());
+    rename(tempfile, savefile);
+    zmbox_index_free(&idx);
+    zmbox_unlock_mailbox(ctx);
+    mutt_unblock_signals();
+    mx_fastclose_mailbox(ctx);
+    mutt_pretty_mailbox(savefile, sizeof(savefile));
+    mutt_error(_("Write failed!  Saved partial mailbox to %s"), savefile);
+    mutt_sleep(5);
+    return -1;
+  }
+
+  mutt_file_fclose(&fp);
+  unlink(tempfile);
+  zmbox_unlock_mailbox(ctx);
+
+  /* the rewritten messages have new headers */
+  for (i = 0, j = 0; i < ctx->msgcount; i++)
+  {
+    struct Header *h = ctx->hdrs[i];
+    if (h->deleted)
+      continue;
+
+    struct ZmboxEntry *e = &idx.entries[j];
+    h->index = j++;
+    h->offset = 0;
+    h->content->hdr_offset = 0;
+    h->content->offset = e->hdrlen;
+    h->content->length = MAX(e->len - (LOFF_T) e->hdrlen - 1, 0);
+    h->lines = e->lines;
+  }
+
+  zmbox_index_free(&zd->index);
+  zd->index = idx;
+  zd->end = (idx.count > 0) ? end : 0;
+  zd->dirty = false;
+
+  /* Restore the previous access/modification times */
+  mbox_reset_atime(ctx, &statbuf);
+
+  ctx->fp = freopen(ctx->path, "r", ctx->fp);
+  if (!ctx->fp || (stat(ctx->path, &statbuf) == -1))
+  {
+    mutt_unblock_signals();
+    mx_fastclose_mailbox(ctx);
+    mutt_error(_("Fatal error!  Could not reopen mailbox!"));
+    return -1;
+  }
+  ctx->size = statbuf.st_size;
+  ctx->mtime = statbuf.st_mtime;
+
+  mutt_unblock_signals();
+  return 0;
+
+bail:
+  mutt_file_fclose(&msgfp);
+  if (fp)
+  {
+    mutt_file_fclose(&fp);
+    unlink(tempfile);
+  }
+  zmbox_index_free(&idx);
+
+  zmbox_unlock_mailbox(ctx);
+  mutt_unblock_signals();
+
+  ctx->fp = freopen(ctx->path, "r", ctx->fp);
+  if (!ctx->fp)
+  {
+    mutt_error(_("Could not reopen mailbox!"));
+    mx_fastclose_mailbox(ctx);
+    return -1;
+  }
+
+  if (need_sort)
+    /* if the mailbox was reopened, the thread tree will be invalid so make
+     * sure to start threading from scratch.  */
+    mutt_sort_headers(ctx, (need_sort == MUTT_REOPENED));
+
+  return rc;
+}
+
+struct MxOps mx_zmbox_ops = {
+  .open = zmbox_open_mailbox,
+  .open_append = zmbox_open_mailbox_append,
+  .close = zmbox_close_mailbox,
+  .open_msg = zmbox_open_message,
+  .close_msg = zmbox_close_message,
+  .commit_msg = zmbox_commit_message,
+  .open_new_msg = zmbox_open_new_message,
+  .check = zmbox_check_mailbox,
+  .sync = zmbox_sync_mailbox,
+  .edit_msg_tags = NULL,
+  .commit_msg_tags = NULL,
+};
@@ -0,0 +1,33 @@
+/**
+ * @file
+ * Compressed mailbox archives
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MUTT_ZMBOX_H
+#define _MUTT_ZMBOX_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+struct Context;
+
+bool zmbox_is_archive(FILE *fp);
+int zmbox_reread_mailbox(struct Context *ctx);
+
+extern struct MxOps mx_zmbox_ops;
+
+#endif /* _MUTT_ZMBOX_H */